@@ -0,0 +1,235 @@
+#include "bucket_kd_tree.h"
+
+typedef std::vector<std::pair<Point, int>> IndexedPoints;
+
+// Build the subtree over items [first, last) and return its position in
+// nodes. Leaves keep their range of items, which ends up in the columns.
+static int buildBucketKDTree(BucketKDTree &tree, IndexedPoints &items, int first, int last, int dim)
+{
+    int nodeIdx = tree.nodes.size();
+    tree.nodes.push_back(BucketKDNode{0, dim, -1, -1, first, last});
+    if (last - first <= tree.bucketSize)
+    {
+        return nodeIdx;
+    }
+    // the median goes right; points tied with it may end up on both sides,
+    // which is why the cut sends equal coordinates down both children
+    int median = first + (last - first) / 2;
+    std::nth_element(items.begin() + first, items.begin() + median, items.begin() + last,
+                     [dim](const std::pair<Point, int> &a, const std::pair<Point, int> &b) {
+                         return a.first.coord[dim] < b.first.coord[dim];
+                     });
+    double split = items[median].first.coord[dim];
+    int left = buildBucketKDTree(tree, items, first, median, 1 - dim);
+    int right = buildBucketKDTree(tree, items, median, last, 1 - dim);
+    // nodes may have been reallocated by the recursive calls
+    tree.nodes[nodeIdx].split = split;
+    tree.nodes[nodeIdx].left = left;
+    tree.nodes[nodeIdx].right = right;
+    return nodeIdx;
+}
+
+BucketKDTree::BucketKDTree(const PointView &points, int bucketSize) : bucketSize(std::max(bucketSize, 1))
+{
+    IndexedPoints items(points.size());
+    for (int i = 0; i < points.size(); i++)
+    {
+        items[i] = std::make_pair(points[i], i);
+    }
+    if (!items.empty())
+    {
+        nodes.reserve(4 * items.size() / this->bucketSize + 1);
+        buildBucketKDTree(*this, items, 0, items.size(), 0);
+    }
+
+    xs.resize(items.size());
+    ys.resize(items.size());
+    indices.resize(items.size());
+    for (int i = 0; i < items.size(); i++)
+    {
+        xs[i] = items[i].first.coord[0];
+        ys[i] = items[i].first.coord[1];
+        indices[i] = items[i].second;
+    }
+}
+
+bool BucketKDTree::searchPoint(const Point &p) const
+{
+    if (nodes.empty())
+    {
+        return false;
+    }
+    // a point equal to p may lie on either side of a cut within eps of it;
+    // the tree is balanced, so the stack never holds more than two nodes per level
+    int stack[128];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+        const BucketKDNode &node = nodes[stack[--stackSize]];
+        if (node.left == -1)
+        {
+            // branch-free scan of the bucket
+            bool found = false;
+            for (int i = node.begin; i < node.end; i++)
+            {
+                found |= (std::abs(xs[i] - p.coord[0]) < POINT_EPS) & (std::abs(ys[i] - p.coord[1]) < POINT_EPS);
+            }
+            if (found)
+            {
+                return true;
+            }
+            continue;
+        }
+        if (p.coord[node.dim] - POINT_EPS <= node.split) stack[stackSize++] = node.left;
+        if (p.coord[node.dim] + POINT_EPS >= node.split) stack[stackSize++] = node.right;
+    }
+    return false;
+}
+
+typedef std::priority_queue<std::pair<double, int>> CandidateHeap;
+
+static void nearestNeighbors(const BucketKDTree &tree, int nodeIdx, const Point &q, int k, CandidateHeap &best)
+{
+    const BucketKDNode &node = tree.nodes[nodeIdx];
+    if (node.left == -1)
+    {
+        for (int i = node.begin; i < node.end; i++)
+        {
+            double dx = tree.xs[i] - q.coord[0];
+            double dy = tree.ys[i] - q.coord[1];
+            double dist = dx * dx + dy * dy;
+            if (best.size() < k)
+            {
+                best.emplace(dist, tree.indices[i]);
+            }
+            else if (dist < best.top().first)
+            {
+                best.pop();
+                best.emplace(dist, tree.indices[i]);
+            }
+        }
+        return;
+    }
+    // visit the side of the cut holding q first, then the other side only
+    // if the cutting line is closer than the current k-th neighbour
+    double diff = q.coord[node.dim] - node.split;
+    int nearSide = diff < 0 ? node.left : node.right;
+    int farSide = diff < 0 ? node.right : node.left;
+    nearestNeighbors(tree, nearSide, q, k, best);
+    if (best.size() < k || diff * diff < best.top().first)
+    {
+        nearestNeighbors(tree, farSide, q, k, best);
+    }
+}
+
+std::vector<int> BucketKDTree::nearestNeighbors(const Point &q, int k) const
+{
+    std::vector<int> result;
+    if (k <= 0 || nodes.empty())
+    {
+        return result;
+    }
+    CandidateHeap best;
+    ::nearestNeighbors(*this, 0, q, k, best);
+    result.resize(best.size());
+    for (int i = (int) best.size() - 1; i >= 0; i--)
+    {
+        result[i] = best.top().second;
+        best.pop();
+    }
+    return result;
+}
+
+static void radiusSearch(const BucketKDTree &tree, int nodeIdx, const Point &q, double r, std::vector<int> &result)
+{
+    const BucketKDNode &node = tree.nodes[nodeIdx];
+    if (node.left == -1)
+    {
+        for (int i = node.begin; i < node.end; i++)
+        {
+            double dx = tree.xs[i] - q.coord[0];
+            double dy = tree.ys[i] - q.coord[1];
+            if (dx * dx + dy * dy <= r * r)
+            {
+                result.push_back(tree.indices[i]);
+            }
+        }
+        return;
+    }
+    double diff = q.coord[node.dim] - node.split;
+    if (diff - r <= 0)
+    {
+        radiusSearch(tree, node.left, q, r, result);
+    }
+    if (diff + r >= 0)
+    {
+        radiusSearch(tree, node.right, q, r, result);
+    }
+}
+
+std::vector<int> BucketKDTree::radiusSearch(const Point &q, double r) const
+{
+    std::vector<int> result;
+    if (!nodes.empty())
+    {
+        ::radiusSearch(*this, 0, q, r, result);
+    }
+    return result;
+}
+
+static void rangeSearch(const BucketKDTree &tree, int nodeIdx, const Point &lo, const Point &hi, std::vector<int> &result)
+{
+    const BucketKDNode &node = tree.nodes[nodeIdx];
+    if (node.left == -1)
+    {
+        for (int i = node.begin; i < node.end; i++)
+        {
+            if (lo.coord[0] <= tree.xs[i] && tree.xs[i] <= hi.coord[0] &&
+                lo.coord[1] <= tree.ys[i] && tree.ys[i] <= hi.coord[1])
+            {
+                result.push_back(tree.indices[i]);
+            }
+        }
+        return;
+    }
+    if (lo.coord[node.dim] <= node.split)
+    {
+        rangeSearch(tree, node.left, lo, hi, result);
+    }
+    if (hi.coord[node.dim] >= node.split)
+    {
+        rangeSearch(tree, node.right, lo, hi, result);
+    }
+}
+
+std::vector<int> BucketKDTree::rangeSearch(const Point &lo, const Point &hi) const
+{
+    std::vector<int> result;
+    if (!nodes.empty())
+    {
+        ::rangeSearch(*this, 0, lo, hi, result);
+    }
+    return result;
+}
+
+static int getTreeHeight(const BucketKDTree &tree, int nodeIdx)
+{
+    const BucketKDNode &node = tree.nodes[nodeIdx];
+    if (node.left == -1)
+    {
+        return 1;
+    }
+    return 1 + std::max(getTreeHeight(tree, node.left), getTreeHeight(tree, node.right));
+}
+
+int BucketKDTree::getTreeHeight() const
+{
+    return nodes.empty() ? 0 : ::getTreeHeight(*this, 0);
+}
+
+size_t BucketKDTree::memoryBytes() const
+{
+    return nodes.capacity() * sizeof(BucketKDNode) + (xs.capacity() + ys.capacity()) * sizeof(double) +
+           indices.capacity() * sizeof(int);
+}
@@ -0,0 +1,46 @@
+#ifndef BUCKET_KD_TREE_H
+#define BUCKET_KD_TREE_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include "point.h"
+
+struct BucketKDNode
+{
+    // internal node: points with coord[dim] <= split are on the left and
+    // points with coord[dim] >= split on the right
+    double split;
+    int dim;
+    // positions of the children in nodes, -1 for a leaf
+    int left, right;
+    // leaf: its points are [begin, end) of the point columns
+    int begin, end;
+};
+
+// K-d tree whose leaves hold up to bucketSize points each. Internal nodes
+// only store the cut; the points are reordered so every leaf is a contiguous
+// run of the x and y columns, which a leaf scans with a plain loop.
+struct BucketKDTree
+{
+    std::vector<BucketKDNode> nodes;
+    std::vector<double> xs, ys;
+    // position in the source point list of each entry of xs and ys
+    std::vector<int> indices;
+    int bucketSize;
+
+    BucketKDTree(const PointView &points, int bucketSize = 16);
+
+    bool searchPoint(const Point &p) const;
+    // Indices of the k points closest to q, from the nearest to the farthest.
+    std::vector<int> nearestNeighbors(const Point &q, int k) const;
+    // Indices of every point at distance at most r from q, in no particular order.
+    std::vector<int> radiusSearch(const Point &q, double r) const;
+    // Indices of every point inside the rectangle [lo.x, hi.x] x [lo.y, hi.y].
+    std::vector<int> rangeSearch(const Point &lo, const Point &hi) const;
+    int getTreeHeight() const;
+    size_t memoryBytes() const;
+};
+
+#endif
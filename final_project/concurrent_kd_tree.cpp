@@ -0,0 +1,98 @@
+#include "concurrent_kd_tree.h"
+
+static double squaredDistance(const Point &a, const Point &b)
+{
+    double dx = a.coord[0] - b.coord[0];
+    double dy = a.coord[1] - b.coord[1];
+    return dx * dx + dy * dy;
+}
+
+Point ConcurrentKDTree::Version::point(int index) const
+{
+    int baseSize = base->points.size();
+    return index < baseSize ? base->points[index] : delta[index - baseSize];
+}
+
+bool ConcurrentKDTree::Version::search(const Point &p) const
+{
+    if (base->tree.search(p))
+    {
+        return true;
+    }
+    for (auto &deltaPoint : delta)
+    {
+        if (deltaPoint == p)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<int> ConcurrentKDTree::Version::nearestNeighbors(const Point &q, int k) const
+{
+    // the k best of the tree and every delta point, merged by distance
+    std::vector<std::pair<double, int>> candidates;
+    for (int index : ::nearestNeighbors(base->tree.root, q, k))
+    {
+        candidates.emplace_back(squaredDistance(base->points[index], q), index);
+    }
+    int baseSize = base->points.size();
+    for (int i = 0; i < delta.size(); i++)
+    {
+        candidates.emplace_back(squaredDistance(delta[i], q), baseSize + i);
+    }
+    int numResults = std::min<int>(std::max(k, 0), candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + numResults, candidates.end());
+
+    std::vector<int> result(numResults);
+    for (int i = 0; i < numResults; i++)
+    {
+        result[i] = candidates[i].second;
+    }
+    return result;
+}
+
+ConcurrentKDTree::ConcurrentKDTree(const PointView &points, size_t deltaThreshold) : deltaThreshold(deltaThreshold)
+{
+    std::vector<Point> basePoints(points.size());
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        basePoints[i] = points[i];
+    }
+    auto version = std::make_shared<Version>();
+    version->base = std::make_shared<const Base>(std::move(basePoints));
+    current = version;
+}
+
+bool ConcurrentKDTree::insert(const Point &p)
+{
+    std::lock_guard<std::mutex> lock(writeMutex);
+    // only writers replace current, so it cannot change under this lock
+    std::shared_ptr<const Version> old = snapshot();
+    if (old->search(p))
+    {
+        return false;
+    }
+
+    auto version = std::make_shared<Version>();
+    if (old->delta.size() + 1 < deltaThreshold)
+    {
+        // share the tree, copy the small delta buffer
+        version->base = old->base;
+        version->delta = old->delta;
+        version->delta.push_back(p);
+    }
+    else
+    {
+        // fold the delta into a freshly built tree
+        std::vector<Point> basePoints;
+        basePoints.reserve(old->size() + 1);
+        basePoints = old->base->points;
+        basePoints.insert(basePoints.end(), old->delta.begin(), old->delta.end());
+        basePoints.push_back(p);
+        version->base = std::make_shared<const Base>(std::move(basePoints));
+    }
+    std::atomic_store(&current, std::shared_ptr<const Version>(std::move(version)));
+    return true;
+}
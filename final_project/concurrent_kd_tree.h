@@ -0,0 +1,57 @@
+#ifndef CONCURRENT_KD_TREE_H
+#define CONCURRENT_KD_TREE_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "kd_tree.h"
+
+// K-d tree for many query threads and an occasional writer. Readers take the
+// current version with an atomic load and search it without locks; a version
+// is never modified once published. Inserts go to a small delta buffer that
+// readers scan linearly; when it reaches deltaThreshold points, the writer
+// builds a new tree over every point and publishes it. Old versions are freed
+// when the last reader holding them lets go.
+// Points are numbered in insertion order, the initial points first.
+struct ConcurrentKDTree
+{
+    // Bulk-built tree over points [0, points.size()).
+    struct Base
+    {
+        std::vector<Point> points;
+        KDTree tree;
+
+        Base(std::vector<Point> &&_points) : points(std::move(_points)), tree(points, 1, true) {}
+    };
+
+    struct Version
+    {
+        std::shared_ptr<const Base> base;
+        // points numbered base->points.size() onwards
+        std::vector<Point> delta;
+
+        size_t size() const { return base->points.size() + delta.size(); }
+        Point point(int index) const;
+        bool search(const Point &p) const;
+        std::vector<int> nearestNeighbors(const Point &q, int k) const;
+    };
+
+    std::shared_ptr<const Version> current;
+    // serializes writers; readers never take it
+    std::mutex writeMutex;
+    size_t deltaThreshold;
+
+    ConcurrentKDTree(const PointView &points, size_t deltaThreshold = 1024);
+
+    // Version to run any number of queries on; it stays valid while held.
+    std::shared_ptr<const Version> snapshot() const { return std::atomic_load(&current); }
+
+    // False if an equal point is already stored.
+    bool insert(const Point &p);
+    bool search(const Point &p) const { return snapshot()->search(p); }
+    std::vector<int> nearestNeighbors(const Point &q, int k) const { return snapshot()->nearestNeighbors(q, k); }
+    size_t size() const { return snapshot()->size(); }
+};
+
+#endif
@@ -0,0 +1,93 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "concurrent_kd_tree.h"
+#include "parallel.h"
+
+const int STD_DEV = 1e2;
+const int NUM_QUERIES = 1e6;
+const int NUM_NEIGHBORS = 10;
+// pause between two inserts of the background writer
+const int WRITE_INTERVAL_US = 100;
+
+// Random query points spread over the same square as the point cloud.
+std::vector<Point> generateQueryPoints(int n)
+{
+    std::vector<Point> result(n);
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> distribution(-400, 400);
+    for (auto &q : result)
+    {
+        q = Point(distribution(generator), distribution(generator));
+    }
+    return result;
+}
+
+// Split the queries over numThreads threads, half exact-match and half
+// nearest-neighbour queries, and report the number of queries per second.
+// With a writer, another thread keeps inserting points meanwhile.
+void benchmarkThroughput(ConcurrentKDTree &tree, std::vector<Point> &queries, int numThreads, bool withWriter)
+{
+    std::atomic<bool> done(false);
+    std::atomic<int> numInserted(0);
+    std::thread writer;
+    if (withWriter)
+    {
+        writer = std::thread([&]()
+        {
+            std::mt19937 generator(11);
+            std::uniform_real_distribution<double> distribution(-400, 400);
+            while (!done)
+            {
+                if (tree.insert(Point(distribution(generator), distribution(generator)))) numInserted++;
+                std::this_thread::sleep_for(std::chrono::microseconds(WRITE_INTERVAL_US));
+            }
+        });
+    }
+
+    std::atomic<long long int> checksum(0);
+    auto begin = std::chrono::steady_clock::now();
+    parallelForChunks(numThreads, queries.size(), [&](int /*t*/, size_t first, size_t last)
+    {
+        long long int localChecksum = 0;
+        for (size_t i = first; i < last; i++)
+        {
+            if (i % 2 == 0) localChecksum += tree.search(queries[i]);
+            else localChecksum += tree.nearestNeighbors(queries[i], NUM_NEIGHBORS).size();
+        }
+        checksum += localChecksum;
+    });
+    auto end = std::chrono::steady_clock::now();
+    done = true;
+    if (withWriter) writer.join();
+
+    double totalTime = std::chrono::duration<double>(end - begin).count();
+    std::cout << "  " << numThreads << " threads" << (withWriter ? " + writer" : "") << ": ";
+    std::cout << queries.size() / totalTime << " queries/s";
+    if (withWriter) std::cout << ", " << numInserted << " points inserted";
+    std::cout << " (checksum " << checksum << ")\n";
+}
+
+int main()
+{
+    std::vector<double> randomPointCloudSize{1e5, 1e6};
+    int maxThreads = std::max<int>(std::thread::hardware_concurrency(), 1);
+    std::vector<Point> queries = generateQueryPoints(NUM_QUERIES);
+    for (int i : randomPointCloudSize)
+    {
+        std::cout << "n = " << i << '\n';
+        std::vector<Point> pointList = Point::generateRandomPointList(i, STD_DEV);
+        ConcurrentKDTree tree(pointList);
+        for (int numThreads = 1; ; numThreads = std::min(2 * numThreads, maxThreads))
+        {
+            benchmarkThroughput(tree, queries, numThreads, false);
+            benchmarkThroughput(tree, queries, numThreads, true);
+            if (numThreads == maxThreads) break;
+        }
+        std::cout << "Points after the writers = " << tree.size() << '\n';
+        std::cout << "------------------------------\n";
+    }
+    return 0;
+}
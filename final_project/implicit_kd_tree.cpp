@@ -0,0 +1,65 @@
+#include "implicit_kd_tree.h"
+
+// Number of nodes in the left subtree of a left-balanced complete tree of n nodes.
+static size_t leftSubtreeSize(size_t n)
+{
+    if (n <= 1)
+    {
+        return 0;
+    }
+    size_t lastLevelCapacity = 1;
+    while (2 * lastLevelCapacity <= n)
+    {
+        lastLevelCapacity *= 2;
+    }
+    // lastLevelCapacity = 2^h where h is the index of the last level
+    size_t fullLevelsNodes = lastLevelCapacity - 1;
+    size_t lastLevelNodes = n - fullLevelsNodes;
+    size_t halfLastLevel = lastLevelCapacity / 2;
+    return (halfLastLevel - 1) + std::min(lastLevelNodes, halfLastLevel);
+}
+
+static void buildImplicit(std::vector<Point> &nodes, std::vector<Point>::iterator first,
+                          std::vector<Point>::iterator last, size_t nodeIdx, int cutDim)
+{
+    if (first == last)
+    {
+        return;
+    }
+    auto median = first + leftSubtreeSize(last - first);
+    std::nth_element(first, median, last, [cutDim](const Point &a, const Point &b) {
+        return lessOnDim(a, b, cutDim);
+    });
+    nodes[nodeIdx] = *median;
+    buildImplicit(nodes, first, median, 2 * nodeIdx + 1, 1 - cutDim);
+    buildImplicit(nodes, median + 1, last, 2 * nodeIdx + 2, 1 - cutDim);
+}
+
+ImplicitKDTree::ImplicitKDTree(const PointView &points)
+{
+    ownedNodes = std::vector<Point>(points.size());
+    std::vector<Point> pointsCopy(points.size());
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        pointsCopy[i] = points[i];
+    }
+    buildImplicit(ownedNodes, pointsCopy.begin(), pointsCopy.end(), 0, 0);
+    nodes = ArrayView<Point>(ownedNodes);
+}
+
+bool ImplicitKDTree::searchPoint(const Point &p) const
+{
+    size_t nodeIdx = 0;
+    int cutDim = 0;
+    while (nodeIdx < nodes.size())
+    {
+        const Point &node = nodes[nodeIdx];
+        if (p == node)
+        {
+            return true;
+        }
+        nodeIdx = lessOnDim(p, node, cutDim) ? 2 * nodeIdx + 1 : 2 * nodeIdx + 2;
+        cutDim = 1 - cutDim;
+    }
+    return false;
+}
@@ -0,0 +1,31 @@
+#ifndef IMPLICIT_KD_TREE_H
+#define IMPLICIT_KD_TREE_H
+
+#include <vector>
+#include <algorithm>
+#include "point.h"
+
+// K-d tree stored as a left-balanced complete binary tree in one array:
+// node i has its children at 2i+1 and 2i+2 and its cutting dimension is
+// its depth modulo 2. Points tied on the cutting coordinate are ordered by
+// the other coordinate, so every point of the left subtree is smaller.
+struct ImplicitKDTree
+{
+    // storage of a tree built in memory, empty for a tree over external nodes
+    std::vector<Point> ownedNodes;
+    ArrayView<Point> nodes;
+
+    ImplicitKDTree() {}
+    ImplicitKDTree(const PointView &points);
+    // Tree over nodes already in implicit order, e.g. mapped from a file by
+    // loadImplicitKDTree; they are not copied and must outlive the tree.
+    ImplicitKDTree(const Point *nodes, size_t count) : nodes(nodes, count) {}
+    // a copy would keep viewing the source's nodes
+    ImplicitKDTree(const ImplicitKDTree &) = delete;
+    ImplicitKDTree &operator=(const ImplicitKDTree &) = delete;
+    ImplicitKDTree(ImplicitKDTree &&) = default;
+    ImplicitKDTree &operator=(ImplicitKDTree &&) = default;
+    bool searchPoint(const Point &p) const;
+};
+
+#endif
@@ -0,0 +1,213 @@
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "index_io.h"
+
+static const char INDEX_FILE_MAGIC[8] = {'C', 'G', 'I', 'N', 'D', 'E', 'X', '\0'};
+
+// Size of an array of the given bytes once padded to a multiple of 8.
+static size_t paddedSize(size_t bytes)
+{
+    return (bytes + 7) / 8 * 8;
+}
+
+MappedFile::MappedFile(const std::string &path) : data(nullptr), size(0)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        std::cout << "ERROR: cannot open " << path << '\n';
+        return;
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0)
+    {
+        void *mapping = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED)
+        {
+            data = (const char *) mapping;
+            size = fileStat.st_size;
+        }
+    }
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+    if (data == nullptr)
+    {
+        std::cout << "ERROR: cannot map " << path << '\n';
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (data != nullptr)
+    {
+        munmap((void *) data, size);
+    }
+}
+
+static IndexFileHeader makeHeader(IndexKind kind, uint64_t numPoints)
+{
+    IndexFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, INDEX_FILE_MAGIC, sizeof(header.magic));
+    header.version = INDEX_FILE_VERSION;
+    header.kind = kind;
+    header.numPoints = numPoints;
+    return header;
+}
+
+static void writeArray(std::ofstream &out, const void *data, size_t bytes)
+{
+    static const char padding[8] = {};
+    out.write((const char *) data, bytes);
+    out.write(padding, paddedSize(bytes) - bytes);
+}
+
+// Header of the file if it holds an index of the given kind whose arrays
+// take arraysBytes(header) bytes, nullptr otherwise.
+template <typename ArraysBytesFn>
+static const IndexFileHeader *checkHeader(const MappedFile &file, IndexKind kind, ArraysBytesFn arraysBytes)
+{
+    if (!file.isOpen() || file.size < sizeof(IndexFileHeader))
+    {
+        std::cout << "ERROR: index file is too small\n";
+        return nullptr;
+    }
+    const IndexFileHeader *header = (const IndexFileHeader *) file.data;
+    if (std::memcmp(header->magic, INDEX_FILE_MAGIC, sizeof(header->magic)) != 0 || header->version != INDEX_FILE_VERSION)
+    {
+        std::cout << "ERROR: not an index file of version " << INDEX_FILE_VERSION << '\n';
+        return nullptr;
+    }
+    if (header->kind != kind)
+    {
+        std::cout << "ERROR: index file holds another kind of index\n";
+        return nullptr;
+    }
+    // the CSR arrays hold int offsets, and larger counts would overflow arraysBytes
+    if (header->numPoints > INT_MAX || header->numCells >= INT_MAX)
+    {
+        std::cout << "ERROR: index file counts are out of range\n";
+        return nullptr;
+    }
+    if (file.size != sizeof(IndexFileHeader) + arraysBytes(*header))
+    {
+        std::cout << "ERROR: index file size does not match its header\n";
+        return nullptr;
+    }
+    return header;
+}
+
+bool saveImplicitKDTree(const ImplicitKDTree &tree, const std::string &path)
+{
+    std::ofstream out(path, std::ios::binary);
+    IndexFileHeader header = makeHeader(IndexKind::ImplicitKDTree, tree.nodes.size());
+    writeArray(out, &header, sizeof(header));
+    writeArray(out, tree.nodes.data, tree.nodes.size() * sizeof(Point));
+    if (!out)
+    {
+        std::cout << "ERROR: cannot write " << path << '\n';
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<ImplicitKDTree> loadImplicitKDTree(const MappedFile &file)
+{
+    const IndexFileHeader *header = checkHeader(file, IndexKind::ImplicitKDTree, [](const IndexFileHeader &h) {
+        return paddedSize(h.numPoints * sizeof(Point));
+    });
+    if (header == nullptr)
+    {
+        return nullptr;
+    }
+    const Point *nodes = (const Point *) (file.data + sizeof(IndexFileHeader));
+    return std::unique_ptr<ImplicitKDTree>(new ImplicitKDTree(nodes, header->numPoints));
+}
+
+bool saveCSRRegularGrid(const CSRRegularGrid &grid, const std::string &path)
+{
+    std::ofstream out(path, std::ios::binary);
+    IndexFileHeader header = makeHeader(IndexKind::CSRRegularGrid, grid.points.size());
+    header.numCells = grid.cellStart.size() - 1;
+    header.cellSize = grid.cellSize;
+    header.xmin = grid.xmin;
+    header.ymin = grid.ymin;
+    header.xmax = grid.xmax;
+    header.ymax = grid.ymax;
+    writeArray(out, &header, sizeof(header));
+    writeArray(out, grid.cellPoints.data, grid.cellPoints.size() * sizeof(Point));
+    writeArray(out, grid.cellPointIndices.data, grid.cellPointIndices.size() * sizeof(int));
+    writeArray(out, grid.cellStart.data, grid.cellStart.size() * sizeof(int));
+    if (!out)
+    {
+        std::cout << "ERROR: cannot write " << path << '\n';
+        return false;
+    }
+    return true;
+}
+
+// True if the cell arrays describe n points: cellStart runs from 0 to n
+// without decreasing, and every entry of cellPointIndices is in [0, n).
+static bool checkCSRArrays(ArrayView<int> cellStart, ArrayView<int> cellPointIndices, size_t n)
+{
+    if (cellStart[0] != 0 || cellStart[cellStart.size() - 1] != (int) n)
+    {
+        return false;
+    }
+    for (size_t c = 1; c < cellStart.size(); c++)
+    {
+        if (cellStart[c] < cellStart[c - 1])
+        {
+            return false;
+        }
+    }
+    for (int pointIdx : cellPointIndices)
+    {
+        if (pointIdx < 0 || pointIdx >= (int) n)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::unique_ptr<CSRRegularGrid> loadCSRRegularGrid(const MappedFile &file)
+{
+    const IndexFileHeader *header = checkHeader(file, IndexKind::CSRRegularGrid, [](const IndexFileHeader &h) {
+        return paddedSize(h.numPoints * sizeof(Point)) + paddedSize(h.numPoints * sizeof(int)) +
+               paddedSize((h.numCells + 1) * sizeof(int));
+    });
+    if (header == nullptr)
+    {
+        return nullptr;
+    }
+    size_t n = header->numPoints;
+    const char *arrays = file.data + sizeof(IndexFileHeader);
+    const Point *cellPoints = (const Point *) arrays;
+    const int *cellPointIndices = (const int *) (arrays + paddedSize(n * sizeof(Point)));
+    const int *cellStart = (const int *) (arrays + paddedSize(n * sizeof(Point)) + paddedSize(n * sizeof(int)));
+    ArrayView<int> cellStartView(cellStart, header->numCells + 1);
+    ArrayView<int> cellPointIndicesView(cellPointIndices, n);
+    if (!checkCSRArrays(cellStartView, cellPointIndicesView, n))
+    {
+        std::cout << "ERROR: index file cell arrays are inconsistent\n";
+        return nullptr;
+    }
+
+    // the cell-ordered points are the only copy in the file, view them as the grid's points
+    std::unique_ptr<CSRRegularGrid> grid(new CSRRegularGrid(
+        PointView(cellPoints, n), header->cellSize, header->xmin, header->ymin, header->xmax, header->ymax,
+        cellStartView, ArrayView<Point>(cellPoints, n), cellPointIndicesView));
+    if (grid->gridSizeX * grid->gridSizeY != (long long int) header->numCells)
+    {
+        std::cout << "ERROR: index file cell count does not match its bounding box\n";
+        return nullptr;
+    }
+    return grid;
+}
@@ -0,0 +1,56 @@
+#ifndef INDEX_IO_H
+#define INDEX_IO_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "implicit_kd_tree.h"
+#include "regular_grid/csr_regular_grid.h"
+
+// On-disk format of a prebuilt index, in the byte order of the machine that
+// wrote it: an IndexFileHeader followed by the index's arrays, each starting
+// at a multiple of 8 bytes.
+//   implicit K-d tree: Point nodes[numPoints]
+//   CSR grid: Point cellPoints[numPoints], int32 cellPointIndices[numPoints],
+//             int32 cellStart[numCells + 1]
+// Loading maps the file and builds the index over the mapped arrays, so
+// nothing is copied or rebuilt; the arrays are checked in one pass first.
+const uint32_t INDEX_FILE_VERSION = 2;
+
+enum class IndexKind : uint32_t { ImplicitKDTree = 1, CSRRegularGrid = 2 };
+
+struct IndexFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    IndexKind kind;
+    uint64_t numPoints;
+    uint64_t numCells;
+    double cellSize;
+    double xmin, ymin, xmax, ymax;
+};
+
+// Read-only memory mapping of a whole file, unmapped on destruction.
+struct MappedFile
+{
+    const char *data;
+    size_t size;
+
+    MappedFile(const std::string &path);
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+    bool isOpen() const { return data != nullptr; }
+};
+
+bool saveImplicitKDTree(const ImplicitKDTree &tree, const std::string &path);
+bool saveCSRRegularGrid(const CSRRegularGrid &grid, const std::string &path);
+
+// Index over the mapped file, nullptr if the file does not hold one. The
+// file must stay mapped while the index is used. A loaded CSR grid keeps only
+// the cell-ordered copy of the points, so its points view is in cell order;
+// the indices its searches return are still those of the saved grid.
+std::unique_ptr<ImplicitKDTree> loadImplicitKDTree(const MappedFile &file);
+std::unique_ptr<CSRRegularGrid> loadCSRRegularGrid(const MappedFile &file);
+
+#endif
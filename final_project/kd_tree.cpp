@@ -1,28 +1,154 @@
 #include "kd_tree.h"
 
-KDNode *insertPoint(KDNode *node, Point p, int cutDim)
+KDNode *KDNodeArena::allocate(Point data, int index)
+{
+    KDNode *node = allocateBlock(1);
+    *node = KDNode(data, index);
+    return node;
+}
+
+KDNode *KDNodeArena::allocateBlock(size_t count)
+{
+    if (count > remaining)
+    {
+        size_t newChunkSize = std::max(count, chunkSize);
+        KDNode *chunk = new KDNode[newChunkSize];
+        chunks.emplace_back(chunk, newChunkSize);
+        next = chunk;
+        remaining = newChunkSize;
+    }
+    KDNode *block = next;
+    next += count;
+    remaining -= count;
+    return block;
+}
+
+void KDNodeArena::clear()
+{
+    for (auto &chunk : chunks)
+    {
+        delete[] chunk.first;
+    }
+    chunks.clear();
+    next = nullptr;
+    remaining = 0;
+}
+
+size_t KDNodeArena::bytesReserved() const
+{
+    size_t numNodes = 0;
+    for (auto &chunk : chunks)
+    {
+        numNodes += chunk.second;
+    }
+    return numNodes * sizeof(KDNode);
+}
+
+KDNode *insertPoint(KDNode *node, Point p, int cutDim, int index, KDNodeArena *arena)
 {
     if (node == nullptr)
     {
-        node = new KDNode(p);
+        node = arena ? arena->allocate(p, index) : new KDNode(p, index);
     }
     else if (p == node->data)
     {
         std::cout << "ERROR: inserting node that already exists\n";
-        node = nullptr;
     }
     // cutDim = 0 -> cutting dimension is x
     // cutDim = 1 -> cutting dimension is y
-    else if (p.coord[cutDim] < node->data.coord[cutDim])
+    else if (lessOnDim(p, node->data, cutDim))
     {
-        node->left = insertPoint(node->left, p, 1 - cutDim);
+        node->left = insertPoint(node->left, p, 1 - cutDim, index, arena);
     }
     else
     {
-        node->right = insertPoint(node->right, p, 1 - cutDim);
+        node->right = insertPoint(node->right, p, 1 - cutDim, index, arena);
+    }
+    node->size = 1 + getSubtreeSize(node->left) + getSubtreeSize(node->right);
+    return node;
+}
+
+// Rebuild [first, last) into a balanced tree cutting first on cutDim, with
+// the same tie rule as buildKDTree.
+static KDNode *rebuildSubtree(std::vector<KDNode *>::iterator first, std::vector<KDNode *>::iterator last, int cutDim)
+{
+    if (first == last)
+    {
+        return nullptr;
     }
+    auto median = first + (last - first) / 2;
+    std::nth_element(first, median, last, [cutDim](KDNode *a, KDNode *b) {
+        return lessOnDim(a->data, b->data, cutDim);
+    });
+    Point split = (*median)->data;
+    auto firstTied = std::partition(first, median, [cutDim, split](KDNode *node) {
+        return lessOnDim(node->data, split, cutDim);
+    });
+    std::iter_swap(firstTied, median);
+    median = firstTied;
+
+    KDNode *node = *median;
+    node->size = last - first;
+    node->left = rebuildSubtree(first, median, 1 - cutDim);
+    node->right = rebuildSubtree(median + 1, last, 1 - cutDim);
     return node;
 }
+
+static KDNode *rebuildSubtree(KDNode *root, int cutDim)
+{
+    std::vector<KDNode *> nodes;
+    nodes.reserve(root->size);
+    std::vector<KDNode *> stack{root};
+    while (!stack.empty())
+    {
+        KDNode *node = stack.back();
+        stack.pop_back();
+        nodes.push_back(node);
+        if (node->left) stack.push_back(node->left);
+        if (node->right) stack.push_back(node->right);
+    }
+    return rebuildSubtree(nodes.begin(), nodes.end(), cutDim);
+}
+
+KDNode *insertPointBalanced(KDNode *root, Point p, double alpha, int index, KDNodeArena *arena)
+{
+    // walk down iteratively: the tree may be deep before its first rebuild
+    std::vector<KDNode *> path;
+    KDNode **link = &root;
+    int cutDim = 0;
+    while (*link != nullptr)
+    {
+        KDNode *node = *link;
+        if (p == node->data)
+        {
+            std::cout << "ERROR: inserting node that already exists\n";
+            return root;
+        }
+        path.push_back(node);
+        link = lessOnDim(p, node->data, cutDim) ? &node->left : &node->right;
+        cutDim = 1 - cutDim;
+    }
+    *link = arena ? arena->allocate(p, index) : new KDNode(p, index);
+    for (KDNode *node : path)
+    {
+        node->size++;
+    }
+
+    for (int depth = 0; depth < path.size(); depth++)
+    {
+        KDNode *node = path[depth];
+        int largestChild = std::max(getSubtreeSize(node->left), getSubtreeSize(node->right));
+        if (largestChild > alpha * node->size)
+        {
+            KDNode *parent = depth > 0 ? path[depth - 1] : nullptr;
+            KDNode **parentLink = parent == nullptr ? &root : parent->left == node ? &parent->left : &parent->right;
+            *parentLink = rebuildSubtree(node, depth % 2);
+            break;
+        }
+    }
+    return root;
+}
+
 bool searchPoint(KDNode *node, Point p, int cutDim)
 {
     bool result = false;
@@ -36,7 +162,7 @@ bool searchPoint(KDNode *node, Point p, int cutDim)
     }
     // cutDim = 0 -> cutting dimension is x
     // cutDim = 1 -> cutting dimension is y
-    else if (p.coord[cutDim] < node->data.coord[cutDim])
+    else if (lessOnDim(p, node->data, cutDim))
     {
         result = searchPoint(node->left, p, 1 - cutDim);
     }
@@ -46,3 +172,282 @@ bool searchPoint(KDNode *node, Point p, int cutDim)
     }
     return result;
 }
+
+void freeKDTree(KDNode *node)
+{
+    if (node == nullptr)
+    {
+        return;
+    }
+    freeKDTree(node->left);
+    freeKDTree(node->right);
+    delete node;
+}
+
+typedef std::vector<std::pair<Point, int>>::iterator IndexedPointIt;
+
+// Subtrees smaller than this are built by the thread that reaches them.
+static const int PARALLEL_BUILD_CUTOFF = 1 << 14;
+
+// block, when given, holds one node per point of [first, last) and the node of
+// the point that ends up at position i of the range is block[i]. The two
+// halves of a split touch disjoint ranges, so while numThreads > 1 the right
+// half is built on a new thread given half of the threads.
+static KDNode *buildKDTree(IndexedPointIt first, IndexedPointIt last, int cutDim, KDNode *block, int numThreads)
+{
+    if (first == last)
+    {
+        return nullptr;
+    }
+    auto median = first + (last - first) / 2;
+    std::nth_element(first, median, last, [cutDim](const std::pair<Point, int> &a, const std::pair<Point, int> &b) {
+        return lessOnDim(a.first, b.first, cutDim);
+    });
+    // points tied on the cutting coordinate are ordered by the other one, so
+    // a line or a column of points still splits in half. searchPoint sends
+    // points not less than the node to the right, so the median must be the
+    // first copy of a repeated point and the left half only smaller points
+    Point split = median->first;
+    auto firstTied = std::partition(first, median, [cutDim, split](const std::pair<Point, int> &p) {
+        return lessOnDim(p.first, split, cutDim);
+    });
+    std::iter_swap(firstTied, median);
+    median = firstTied;
+
+    KDNode *node;
+    KDNode *leftBlock = nullptr;
+    KDNode *rightBlock = nullptr;
+    if (block)
+    {
+        node = block + (median - first);
+        *node = KDNode(median->first, median->second);
+        leftBlock = block;
+        rightBlock = node + 1;
+    }
+    else
+    {
+        node = new KDNode(median->first, median->second);
+    }
+    node->size = last - first;
+    if (numThreads > 1 && last - first > PARALLEL_BUILD_CUTOFF)
+    {
+        int rightThreads = numThreads / 2;
+        std::thread rightBuilder([&]() {
+            node->right = buildKDTree(median + 1, last, 1 - cutDim, rightBlock, rightThreads);
+        });
+        node->left = buildKDTree(first, median, 1 - cutDim, leftBlock, numThreads - rightThreads);
+        rightBuilder.join();
+    }
+    else
+    {
+        node->left = buildKDTree(first, median, 1 - cutDim, leftBlock, 1);
+        node->right = buildKDTree(median + 1, last, 1 - cutDim, rightBlock, 1);
+    }
+    return node;
+}
+
+template <typename View>
+static KDNode *buildKDTreeFromView(const View &points, KDNodeArena *arena, int numThreads)
+{
+    // partition a copy so the caller's point order is left untouched
+    std::vector<std::pair<Point, int>> indexedPoints(points.size());
+    for (int i = 0; i < points.size(); i++)
+    {
+        indexedPoints[i] = std::make_pair(points[i], i);
+    }
+    KDNode *block = arena && !points.empty() ? arena->allocateBlock(points.size()) : nullptr;
+    return buildKDTree(indexedPoints.begin(), indexedPoints.end(), 0, block, numThreads);
+}
+
+KDNode *buildKDTree(const PointView &points, KDNodeArena *arena, int numThreads)
+{
+    return buildKDTreeFromView(points, arena, numThreads);
+}
+
+KDNode *buildKDTree(const FloatPointView &points, KDNodeArena *arena, int numThreads)
+{
+    return buildKDTreeFromView(points, arena, numThreads);
+}
+
+int getTreeHeight(KDNode *node)
+{
+    if (node == nullptr)
+    {
+        return 0;
+    }
+    return 1 + std::max(getTreeHeight(node->left), getTreeHeight(node->right));
+}
+
+static double squaredDistance(const Point &a, const Point &b)
+{
+    double dx = a.coord[0] - b.coord[0];
+    double dy = a.coord[1] - b.coord[1];
+    return dx * dx + dy * dy;
+}
+
+// max-heap of (squared distance, index) holding the best candidates so far
+typedef std::priority_queue<std::pair<double, int>> CandidateHeap;
+
+static void nearestNeighbors(KDNode *node, const Point &q, int k, int cutDim, CandidateHeap &best)
+{
+    if (node == nullptr)
+    {
+        return;
+    }
+    double dist = squaredDistance(node->data, q);
+    if (best.size() < k)
+    {
+        best.emplace(dist, node->index);
+    }
+    else if (dist < best.top().first)
+    {
+        best.pop();
+        best.emplace(dist, node->index);
+    }
+
+    // visit the side of the cut holding q first, then the other side only
+    // if the cutting line is closer than the current k-th neighbour; both
+    // sides may hold points on the line
+    double diff = q.coord[cutDim] - node->data.coord[cutDim];
+    bool leftFirst = lessOnDim(q, node->data, cutDim);
+    KDNode *nearSide = leftFirst ? node->left : node->right;
+    KDNode *farSide = leftFirst ? node->right : node->left;
+    nearestNeighbors(nearSide, q, k, 1 - cutDim, best);
+    if (best.size() < k || diff * diff < best.top().first)
+    {
+        nearestNeighbors(farSide, q, k, 1 - cutDim, best);
+    }
+}
+
+std::vector<int> nearestNeighbors(KDNode *root, const Point &q, int k)
+{
+    std::vector<int> result;
+    if (k <= 0)
+    {
+        return result;
+    }
+    CandidateHeap best;
+    nearestNeighbors(root, q, k, 0, best);
+    result.resize(best.size());
+    for (int i = (int) best.size() - 1; i >= 0; i--)
+    {
+        result[i] = best.top().second;
+        best.pop();
+    }
+    return result;
+}
+
+static void radiusSearch(KDNode *node, const Point &q, double r, int cutDim, std::vector<int> &result)
+{
+    if (node == nullptr)
+    {
+        return;
+    }
+    if (squaredDistance(node->data, q) <= r * r)
+    {
+        result.push_back(node->index);
+    }
+    // points on the cutting line can be on either side
+    double diff = q.coord[cutDim] - node->data.coord[cutDim];
+    if (diff - r <= 0)
+    {
+        radiusSearch(node->left, q, r, 1 - cutDim, result);
+    }
+    if (diff + r >= 0)
+    {
+        radiusSearch(node->right, q, r, 1 - cutDim, result);
+    }
+}
+
+std::vector<int> radiusSearch(KDNode *root, const Point &q, double r)
+{
+    std::vector<int> result;
+    radiusSearch(root, q, r, 0, result);
+    return result;
+}
+
+static void rangeSearch(KDNode *node, const Point &lo, const Point &hi, int cutDim, std::vector<int> &result)
+{
+    if (node == nullptr)
+    {
+        return;
+    }
+    const Point &p = node->data;
+    if (lo.coord[0] <= p.coord[0] && p.coord[0] <= hi.coord[0] &&
+        lo.coord[1] <= p.coord[1] && p.coord[1] <= hi.coord[1])
+    {
+        result.push_back(node->index);
+    }
+    // points on the cutting line can be on either side
+    if (lo.coord[cutDim] <= p.coord[cutDim])
+    {
+        rangeSearch(node->left, lo, hi, 1 - cutDim, result);
+    }
+    if (hi.coord[cutDim] >= p.coord[cutDim])
+    {
+        rangeSearch(node->right, lo, hi, 1 - cutDim, result);
+    }
+}
+
+std::vector<int> rangeSearch(KDNode *root, const Point &lo, const Point &hi)
+{
+    std::vector<int> result;
+    rangeSearch(root, lo, hi, 0, result);
+    return result;
+}
+
+KDTree::KDTree(const PointView &points, int numThreads, bool usePointSet) : usePointSet(usePointSet), balanceAlpha(0)
+{
+    if (usePointSet)
+    {
+        pointSet = PointHashSet(points);
+    }
+    root = buildKDTree(points, &arena, numThreads);
+    size = points.size();
+}
+
+KDTree::KDTree(const FloatPointView &points, int numThreads, bool usePointSet) : usePointSet(usePointSet), balanceAlpha(0)
+{
+    if (usePointSet)
+    {
+        pointSet = PointHashSet(points);
+    }
+    root = buildKDTree(points, &arena, numThreads);
+    size = points.size();
+}
+
+bool KDTree::insert(Point p, int index)
+{
+    // the node and the set must agree on the index
+    if (index == -1)
+    {
+        index = size;
+    }
+    if (usePointSet && !pointSet.insert(p, index))
+    {
+        return false;
+    }
+    int sizeBefore = getSubtreeSize(root);
+    if (balanceAlpha > 0)
+    {
+        root = insertPointBalanced(root, p, balanceAlpha, index, &arena);
+    }
+    else
+    {
+        root = insertPoint(root, p, 0, index, &arena);
+    }
+    if (getSubtreeSize(root) == sizeBefore)
+    {
+        return false;
+    }
+    size++;
+    return true;
+}
+
+void KDTree::clear()
+{
+    arena.clear();
+    pointSet.clear();
+    root = nullptr;
+    size = 0;
+}
@@ -5,19 +5,109 @@
 #include <vector>
 #include <algorithm>
 #include <chrono>
+#include <queue>
+#include <thread>
 #include "point.h"
+#include "point_hash_set.h"
 
 struct KDNode
 {
     Point data;
+    // position of data in the point list the tree was built from (-1 if unknown)
+    int index;
+    // number of nodes in the subtree rooted here
+    int size;
     KDNode *left;
     KDNode *right;
 
     KDNode() {}
-    KDNode(Point data) : data(data), left(nullptr), right(nullptr) {}
+    KDNode(Point data, int index = -1) : data(data), index(index), size(1), left(nullptr), right(nullptr) {}
 };
 
-KDNode *insertPoint(KDNode *node, Point p, int cutDim = 0);
+inline int getSubtreeSize(KDNode *node)
+{
+    return node ? node->size : 0;
+}
+
+// Hands out KDNodes from large chunks with a bump pointer. Nodes are never
+// freed one by one; clear() and the destructor release every chunk at once.
+struct KDNodeArena
+{
+    std::vector<std::pair<KDNode *, size_t>> chunks;
+    size_t chunkSize;
+    KDNode *next;
+    size_t remaining;
+
+    KDNodeArena(size_t chunkSize = 1 << 16) : chunkSize(chunkSize), next(nullptr), remaining(0) {}
+    KDNodeArena(const KDNodeArena &) = delete;
+    KDNodeArena &operator=(const KDNodeArena &) = delete;
+    ~KDNodeArena() { clear(); }
+
+    KDNode *allocate(Point data, int index);
+    // count contiguous nodes, left uninitialized
+    KDNode *allocateBlock(size_t count);
+    void clear();
+    size_t bytesReserved() const;
+};
+
+// Nodes come from arena when one is given, from new otherwise. A point equal
+// to one already in the tree is reported and leaves the tree unchanged.
+KDNode *insertPoint(KDNode *node, Point p, int cutDim = 0, int index = -1, KDNodeArena *arena = nullptr);
+// Scapegoat insertion: after the insert, the highest subtree on the path in
+// which a child holds more than alpha of the nodes (0.5 < alpha < 1) is
+// rebuilt balanced, reusing its nodes. This keeps the depth O(log n) for any
+// insertion order, sorted input included. Returns the new root.
+KDNode *insertPointBalanced(KDNode *root, Point p, double alpha, int index = -1, KDNodeArena *arena = nullptr);
 bool searchPoint(KDNode *node, Point p, int cutDim = 0);
+// Delete a tree whose nodes were allocated with new.
+void freeKDTree(KDNode *node);
+
+// Indices of the k points closest to q, from the nearest to the farthest.
+std::vector<int> nearestNeighbors(KDNode *root, const Point &q, int k);
+// Indices of every point at distance at most r from q, in no particular order.
+std::vector<int> radiusSearch(KDNode *root, const Point &q, double r);
+// Indices of every point inside the rectangle [lo.x, hi.x] x [lo.y, hi.y].
+std::vector<int> rangeSearch(KDNode *root, const Point &lo, const Point &hi);
+
+// Build a balanced tree in one step by splitting at the median of the
+// alternating cutting dimension, so its height is ceil(log2(n + 1)).
+// With an arena, the whole tree is taken from it as one contiguous block.
+// Subtrees are built on up to numThreads threads; the tree is the same for
+// any thread count.
+KDNode *buildKDTree(const PointView &points, KDNodeArena *arena = nullptr, int numThreads = 1);
+KDNode *buildKDTree(const FloatPointView &points, KDNodeArena *arena = nullptr, int numThreads = 1);
+int getTreeHeight(KDNode *node);
+
+// Owns a tree whose nodes live in an arena, so it can be dropped in O(chunks).
+// With usePointSet its points are also kept in a hash set that answers
+// membership tests and catches duplicates without walking the tree, at the
+// cost of the set's memory and of one set insertion per insert.
+struct KDTree
+{
+    KDNodeArena arena;
+    KDNode *root;
+    int size;
+    bool usePointSet;
+    PointHashSet pointSet;
+    // 0 for plain insertion, otherwise the alpha of insertPointBalanced
+    double balanceAlpha;
+
+    explicit KDTree(bool usePointSet = false) : root(nullptr), size(0), usePointSet(usePointSet), balanceAlpha(0) {}
+    KDTree(const PointView &points, int numThreads = 1, bool usePointSet = false);
+    // The tree keeps the doubles the floats read back as, so search compares
+    // with queries rounded by FloatPointView::round.
+    KDTree(const FloatPointView &points, int numThreads = 1, bool usePointSet = false);
+
+    // False, leaving the tree unchanged, if an equal point is already stored;
+    // without the set insertPoint also reports it. An index of -1 is replaced
+    // by the number of points in the tree.
+    bool insert(Point p, int index = -1);
+    bool search(Point p) const { return usePointSet ? pointSet.contains(p) : searchPoint(root, p); }
+    std::vector<int> nearestNeighbors(const Point &q, int k) { return ::nearestNeighbors(root, q, k); }
+    std::vector<int> radiusSearch(const Point &q, double r) { return ::radiusSearch(root, q, r); }
+    std::vector<int> rangeSearch(const Point &lo, const Point &hi) { return ::rangeSearch(root, lo, hi); }
+    void clear();
+    size_t memoryBytes() const { return arena.bytesReserved() + (usePointSet ? pointSet.memoryBytes() : 0); }
+};
 
 #endif
\ No newline at end of file
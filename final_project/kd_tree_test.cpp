@@ -1,6 +1,195 @@
+#include <string>
+#include <thread>
 #include "kd_tree.h"
+#include "implicit_kd_tree.h"
+#include "bucket_kd_tree.h"
+#include "index_io.h"
 
 const int STD_DEV = 1e2;
+const int NUM_QUERIES = 1e5;
+const int NUM_NEIGHBORS = 10;
+const double QUERY_RADIUS = 2.0;
+const double SCAPEGOAT_ALPHA = 0.7;
+// bound on scapegoat insertion time over bulk build time
+const double MAX_SCAPEGOAT_SLOWDOWN = 100;
+const std::vector<int> BUCKET_SIZES{8, 16, 32, 64};
+
+// Search every other point of the list and a shifted copy of it, so half
+// of the queries hit and half miss.
+template <typename SearchFn>
+void benchmarkPointSearch(const std::string &name, std::vector<Point> &pointList, SearchFn search)
+{
+    int numPointInList = 0;
+    int numPointNotInList = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < pointList.size(); i += 2)
+    {
+        Point modifiedPoint = pointList[i];
+        modifiedPoint.coord[0] += 0.5;
+        modifiedPoint.coord[1] += 0.5;
+        if(search(pointList[i])) numPointInList++;
+        else numPointNotInList++;
+
+        if(search(modifiedPoint)) numPointInList++;
+        else numPointNotInList++;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double totalSearchTime = std::chrono::duration<double, std::milli>(end - begin).count();
+
+    std::cout << "Average point-search time (" << name << ") = " << totalSearchTime/pointList.size() << "[ms]\n";
+    std::cout << "Number of points in list = " << numPointInList << '\n';
+    std::cout << "Number of points not in list = " << numPointNotInList << '\n';
+}
+
+// Random query points spread over the same square as the point cloud.
+std::vector<Point> generateQueryPoints(int n)
+{
+    std::vector<Point> result(n);
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> distribution(-400, 400);
+    for (auto &q : result)
+    {
+        q = Point(distribution(generator), distribution(generator));
+    }
+    return result;
+}
+
+template <typename QueryFn>
+void benchmarkQuery(const std::string &name, std::vector<Point> &queries, QueryFn query)
+{
+    long long int numResults = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (auto &q : queries)
+    {
+        numResults += query(q).size();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double totalQueryTime = std::chrono::duration<double, std::micro>(end - begin).count();
+
+    std::cout << "Average " << name << " query time = " << totalQueryTime/queries.size() << "[us]";
+    std::cout << " (" << (double) numResults/queries.size() << " points per query)\n";
+}
+
+bool sameTree(KDNode *a, KDNode *b)
+{
+    if (a == nullptr || b == nullptr)
+    {
+        return a == b;
+    }
+    return a->index == b->index && sameTree(a->left, b->left) && sameTree(a->right, b->right);
+}
+
+// Time the bulk build for growing thread counts and check it builds the same tree.
+void benchmarkParallelBuild(std::vector<Point> &pointList)
+{
+    KDNodeArena serialArena;
+    KDNode *serialRoot = buildKDTree(pointList, &serialArena);
+    int maxThreads = std::max<int>(std::thread::hardware_concurrency(), 1);
+    double serialTime = 0;
+    for (int numThreads = 1; ; numThreads = std::min(2 * numThreads, maxThreads))
+    {
+        KDNodeArena arena;
+        auto begin = std::chrono::steady_clock::now();
+        KDNode *root = buildKDTree(pointList, &arena, numThreads);
+        auto end = std::chrono::steady_clock::now();
+        double buildTime = std::chrono::duration<double, std::milli>(end - begin).count();
+        if (numThreads == 1) serialTime = buildTime;
+
+        std::cout << "Construct tree time (bulk, " << numThreads << " threads) = " << buildTime << "[ms]";
+        std::cout << ", speedup = " << serialTime / buildTime;
+        std::cout << ", same as serial = " << (sameTree(root, serialRoot) ? "yes" : "NO") << '\n';
+        if (numThreads == maxThreads) break;
+    }
+}
+
+// Incremental construction with and without scapegoat rebuilds for random,
+// x-sorted and reverse x-sorted arrival orders.
+void benchmarkInsertionOrder(std::vector<Point> &pointList)
+{
+    std::vector<Point> sortedPointList = pointList;
+    std::sort(sortedPointList.begin(), sortedPointList.end(), [](const Point &a, const Point &b) {
+        return a.coord[0] < b.coord[0];
+    });
+    std::vector<Point> reversePointList(sortedPointList.rbegin(), sortedPointList.rend());
+    std::vector<std::pair<std::string, std::vector<Point> *>> orders{
+        {"random", &pointList}, {"sorted", &sortedPointList}, {"reverse sorted", &reversePointList}};
+
+    for (auto &order : orders)
+    {
+        for (double alpha : {0.0, SCAPEGOAT_ALPHA})
+        {
+            std::string name = order.first + (alpha == 0 ? ", plain" : ", scapegoat");
+            KDTree tree;
+            tree.balanceAlpha = alpha;
+            auto begin = std::chrono::steady_clock::now();
+            for (int j = 0; j < order.second->size(); j++)
+            {
+                tree.insert((*order.second)[j], j);
+            }
+            auto end = std::chrono::steady_clock::now();
+            std::cout << "Construct tree time (" << name << ") = " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms]";
+            std::cout << ", height = " << getTreeHeight(tree.root) << '\n';
+            benchmarkPointSearch(name, *order.second, [&](Point &p) { return searchPoint(tree.root, p); });
+        }
+    }
+}
+
+// Points sharing a coordinate, inserted in x order: the scapegoat rebuilds
+// must still split them, or every insert rebuilds a large subtree again.
+void benchmarkRepeatedCoordinates(int n)
+{
+    std::mt19937 generator(11);
+    std::uniform_real_distribution<double> distribution(-400, 400);
+    std::vector<std::pair<std::string, std::vector<Point>>> clouds;
+    for (int distinctX : {1, 10, 100})
+    {
+        std::vector<Point> pointList(n);
+        for (int j = 0; j < n; j++)
+        {
+            pointList[j] = Point(j * distinctX / n, distribution(generator));
+        }
+        clouds.emplace_back(std::to_string(distinctX) + " distinct x", pointList);
+    }
+    // a grid repeats both coordinates
+    std::vector<Point> gridPointList(n);
+    int side = std::sqrt(n);
+    for (int j = 0; j < n; j++)
+    {
+        gridPointList[j] = Point(j / side, j % side);
+    }
+    clouds.emplace_back("grid", gridPointList);
+
+    for (auto &cloud : clouds)
+    {
+        std::vector<Point> &pointList = cloud.second;
+        auto begin = std::chrono::steady_clock::now();
+        KDTree bulkTree(pointList);
+        auto end = std::chrono::steady_clock::now();
+        double bulkTime = std::chrono::duration<double, std::milli>(end - begin).count();
+
+        KDTree tree;
+        tree.balanceAlpha = SCAPEGOAT_ALPHA;
+        begin = std::chrono::steady_clock::now();
+        for (int j = 0; j < pointList.size(); j++)
+        {
+            tree.insert(pointList[j], j);
+        }
+        end = std::chrono::steady_clock::now();
+        double buildTime = std::chrono::duration<double, std::milli>(end - begin).count();
+        std::string name = "scapegoat, " + cloud.first;
+        std::cout << "Construct tree time (" << name << ") = " << buildTime << "[ms]";
+        std::cout << ", bulk = " << bulkTime << "[ms], height = " << getTreeHeight(tree.root) << '\n';
+        // the rebuilds cost O(log^2 n) per insert amortized, against O(log n)
+        // for the bulk build
+        if (buildTime > MAX_SCAPEGOAT_SLOWDOWN * bulkTime + 10)
+        {
+            std::cout << "ERROR: scapegoat insertion is over " << MAX_SCAPEGOAT_SLOWDOWN << " times slower than the bulk build\n";
+        }
+        benchmarkPointSearch(name, pointList, [&](Point &p) { return tree.search(p); });
+    }
+    std::cout << "------------------------------\n";
+}
 
 int main()
 {
@@ -8,6 +197,8 @@ int main()
     std::chrono::steady_clock::time_point begin;
     std::chrono::steady_clock::time_point end;
 
+    benchmarkRepeatedCoordinates(2e4);
+
     std::vector<double> randomPointCloudSize{1e3, 5*1e3, 1e4, 5*1e4, 1e5, 5*1e5, 1e6, 5*1e6};
     for (int i : randomPointCloudSize)
     {
@@ -16,35 +207,88 @@ int main()
         // Point::createPointCloudFile(i, pointList);
         KDNode *root = nullptr;
         begin = std::chrono::steady_clock::now();
-        for (auto &p : pointList)
+        for (int j = 0; j < pointList.size(); j++)
         {
-            root = insertPoint(root, p);
+            root = insertPoint(root, pointList[j], 0, j);
         }
         end = std::chrono::steady_clock::now();
-        std::cout << "Construct tree time = " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms]\n";
+        std::cout << "Construct tree time (incremental, new) = " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms]\n";
+        std::cout << "Tree height (incremental) = " << getTreeHeight(root) << '\n';
+        benchmarkPointSearch("incremental, new", pointList, [&](Point &p) { return searchPoint(root, p); });
+        freeKDTree(root);
 
-        int numPointInList = 0;
-        int numPointNotInList = 0;
+        KDTree incrementalTree;
         begin = std::chrono::steady_clock::now();
-        for (int i = 0; i < pointList.size(); i += 2)
+        for (int j = 0; j < pointList.size(); j++)
         {
-            Point modifiedPoint = pointList[i];
-            modifiedPoint.coord[0] += 0.5;
-            modifiedPoint.coord[1] += 0.5;
-            if(searchPoint(root, pointList[i])) numPointInList++;
-            else numPointNotInList++;
-            
-            if(searchPoint(root, modifiedPoint)) numPointInList++;
-            else numPointNotInList++; 
+            incrementalTree.insert(pointList[j], j);
         }
         end = std::chrono::steady_clock::now();
+        std::cout << "Construct tree time (incremental, arena) = " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms]\n";
+        std::cout << "Bytes per point (incremental, arena) = " << (double) incrementalTree.memoryBytes()/pointList.size() << '\n';
+        benchmarkPointSearch("incremental, arena", pointList, [&](Point &p) { return searchPoint(incrementalTree.root, p); });
+        incrementalTree.clear();
+        benchmarkInsertionOrder(pointList);
+
+        begin = std::chrono::steady_clock::now();
+        KDTree bulkTree(pointList);
+        end = std::chrono::steady_clock::now();
+        std::cout << "Construct tree time (bulk) = " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms]\n";
+        std::cout << "Tree height (bulk) = " << getTreeHeight(bulkTree.root) << '\n';
+        std::cout << "Bytes per point (bulk) = " << (double) bulkTree.memoryBytes()/pointList.size() << '\n';
+        benchmarkParallelBuild(pointList);
+
+        begin = std::chrono::steady_clock::now();
+        ImplicitKDTree implicitTree(pointList);
+        end = std::chrono::steady_clock::now();
+        std::cout << "Construct tree time (implicit array) = " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms]\n";
+        std::cout << "Bytes per point (implicit array) = " << (double) implicitTree.ownedNodes.capacity()*sizeof(Point)/pointList.size() << '\n';
 
-        double totalSearchTime = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
-        
-        std::cout << "Average point-search time = " << totalSearchTime/pointList.size() << "[ms]\n";
-        std::cout << "Number of points in list = " << numPointInList << '\n';
-        std::cout << "Number of points not in list = " << numPointNotInList << '\n';
+        benchmarkPointSearch("bulk", pointList, [&](Point &p) { return searchPoint(bulkTree.root, p); });
+        benchmarkPointSearch("implicit array", pointList, [&](Point &p) { return implicitTree.searchPoint(p); });
+        KDTree setTree(pointList, 1, true);
+        std::cout << "Bytes per point (bulk, hash set) = " << (double) setTree.memoryBytes()/pointList.size() << '\n';
+        benchmarkPointSearch("hash set", pointList, [&](Point &p) { return setTree.search(p); });
+
+        // save the implicit tree and time how long it takes to be queryable again
+        std::string indexPath = "implicitKDTree" + std::to_string(i) + ".idx";
+        saveImplicitKDTree(implicitTree, indexPath);
+        begin = std::chrono::steady_clock::now();
+        {
+            MappedFile indexFile(indexPath);
+            auto loadedTree = loadImplicitKDTree(indexFile);
+            end = std::chrono::steady_clock::now();
+            std::cout << "Load tree time (implicit array, mapped) = " << std::chrono::duration<double, std::milli>(end - begin).count() << "[ms]\n";
+            if (loadedTree) benchmarkPointSearch("implicit array, mapped", pointList, [&](Point &p) { return loadedTree->searchPoint(p); });
+        }
+        std::remove(indexPath.c_str());
+
+        std::vector<Point> queries = generateQueryPoints(NUM_QUERIES);
+        benchmarkQuery(std::to_string(NUM_NEIGHBORS) + "-nearest-neighbours", queries, [&](Point &q) {
+            return bulkTree.nearestNeighbors(q, NUM_NEIGHBORS);
+        });
+        benchmarkQuery("radius", queries, [&](Point &q) {
+            return bulkTree.radiusSearch(q, QUERY_RADIUS);
+        });
+
+        for (int bucketSize : BUCKET_SIZES)
+        {
+            std::string name = "bucket " + std::to_string(bucketSize);
+            begin = std::chrono::steady_clock::now();
+            BucketKDTree bucketTree(pointList, bucketSize);
+            end = std::chrono::steady_clock::now();
+            std::cout << "Construct tree time (" << name << ") = " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms]\n";
+            std::cout << "Tree height (" << name << ") = " << bucketTree.getTreeHeight() << '\n';
+            std::cout << "Bytes per point (" << name << ") = " << (double) bucketTree.memoryBytes()/pointList.size() << '\n';
+            benchmarkPointSearch(name, pointList, [&](Point &p) { return bucketTree.searchPoint(p); });
+            benchmarkQuery(std::to_string(NUM_NEIGHBORS) + "-nearest-neighbours (" + name + ")", queries, [&](Point &q) {
+                return bucketTree.nearestNeighbors(q, NUM_NEIGHBORS);
+            });
+            benchmarkQuery("radius (" + name + ")", queries, [&](Point &q) {
+                return bucketTree.radiusSearch(q, QUERY_RADIUS);
+            });
+        }
         std::cout << "------------------------------\n";
     }
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,81 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include "point.h"
+#include "kd_tree.h"
+#include "regular_grid/hash_regular_grid.h"
+#include "regular_grid/matrix_regular_grid.h"
+
+const int STD_DEV = 1e2;
+const int NUM_QUERIES = 1e5;
+const int NUM_NEIGHBORS = 10;
+const double POINTS_PER_CELL = 2.0;
+const int DENSITY_SAMPLE_SIZE = 1e4;
+
+// Queries that follow the cloud: random points of the list moved by up to a
+// few units, so skewed clouds are queried where their points are.
+std::vector<Point> generateQueryPoints(std::vector<Point> &pointList, int n)
+{
+    std::vector<Point> result(n);
+    std::mt19937 generator(7);
+    std::uniform_int_distribution<int> pick(0, pointList.size() - 1);
+    std::uniform_real_distribution<double> offset(-5, 5);
+    for (auto &q : result)
+    {
+        Point p = pointList[pick(generator)];
+        q = Point(p.coord[0] + offset(generator), p.coord[1] + offset(generator));
+    }
+    return result;
+}
+
+template <typename QueryFn>
+void benchmarkNearest(const std::string &name, std::vector<Point> &queries, QueryFn query)
+{
+    long long int checksum = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (auto &q : queries)
+    {
+        checksum += query(q);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double totalQueryTime = std::chrono::duration<double, std::micro>(end - begin).count();
+
+    std::cout << "  " << name << ": " << totalQueryTime/queries.size() << "[us] per query";
+    std::cout << " (checksum " << checksum << ")\n";
+}
+
+// Nearest and k-nearest queries on the bulk-built K-d tree and on the grids,
+// with the grid cell size picked from the cloud's density.
+void benchmarkCloud(const std::string &cloudName, std::vector<Point> &pointList)
+{
+    std::cout << cloudName << " cloud\n";
+    std::vector<Point> queries = generateQueryPoints(pointList, NUM_QUERIES);
+    CellSizeOptions options(POINTS_PER_CELL, DENSITY_SAMPLE_SIZE);
+    KDTree tree(pointList);
+    MatrixRegularGrid matrixGrid(pointList, options);
+    HashRegularGrid hashGrid(pointList, options);
+
+    benchmarkNearest("K-d tree, nearest", queries, [&](Point &q) { return tree.nearestNeighbors(q, 1)[0]; });
+    benchmarkNearest("matrix grid, nearest", queries, [&](Point &q) { return matrixGrid.nearest(q); });
+    benchmarkNearest("hash grid, nearest", queries, [&](Point &q) { return hashGrid.nearest(q); });
+
+    std::string k = std::to_string(NUM_NEIGHBORS);
+    benchmarkNearest("K-d tree, " + k + "-nearest", queries, [&](Point &q) { return tree.nearestNeighbors(q, NUM_NEIGHBORS).back(); });
+    benchmarkNearest("matrix grid, " + k + "-nearest", queries, [&](Point &q) { return matrixGrid.kNearest(q, NUM_NEIGHBORS).back(); });
+    benchmarkNearest("hash grid, " + k + "-nearest", queries, [&](Point &q) { return hashGrid.kNearest(q, NUM_NEIGHBORS).back(); });
+}
+
+int main()
+{
+    std::vector<double> randomPointCloudSize{1e4, 1e5, 1e6, 5*1e6};
+    for (int i : randomPointCloudSize)
+    {
+        std::cout << "n = " << i << '\n';
+        std::vector<Point> uniformPointList = Point::generateRandomPointList(i, STD_DEV);
+        benchmarkCloud("uniform", uniformPointList);
+        std::vector<Point> normalPointList = Point::generateNormalPointList(i, STD_DEV);
+        benchmarkCloud("normal", normalPointList);
+        std::cout << "------------------------------\n";
+    }
+    return 0;
+}
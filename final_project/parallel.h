@@ -0,0 +1,28 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Split [0, n) into numThreads contiguous chunks and call fn(thread, begin, end)
+// for each of them, the calling thread taking the first chunk. Chunk t always
+// covers the same range for a given n and numThreads.
+template <typename Fn>
+void parallelForChunks(int numThreads, size_t n, Fn fn)
+{
+    numThreads = std::max(numThreads, 1);
+    std::vector<std::thread> threads;
+    for (int t = 1; t < numThreads; t++)
+    {
+        threads.emplace_back(fn, t, n * t / numThreads, n * (t + 1) / numThreads);
+    }
+    fn(0, (size_t) 0, n / numThreads);
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+#endif
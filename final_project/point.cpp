@@ -30,6 +30,18 @@ std::vector<Point> Point::generateRandomPointList(int n, int stdDev)
     return result;
 }
 
+std::vector<Point> Point::generateNormalPointList(int n, int stdDev)
+{
+    std::vector<Point> result(n);
+    std::default_random_engine generator;
+    std::normal_distribution<double> distribution(0.0, stdDev);
+    for (int i = 0; i < n; i++)
+    {
+        result[i] = Point(distribution(generator), distribution(generator));
+    }
+    return result;
+}
+
 void Point::createPointCloudFile(int n, std::vector<Point> pointList) {
     std::ofstream outFile;
     outFile.open("uniformPointCloud" + std::to_string(n) + ".txt");
@@ -37,4 +49,4 @@ void Point::createPointCloudFile(int n, std::vector<Point> pointList) {
         outFile << p.coord[0] << " " << p.coord[1] << '\n';
     }
     outFile.close();
-}
\ No newline at end of file
+}
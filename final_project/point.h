@@ -2,10 +2,15 @@
 #define POINT_H
 
 #include <random>
+#include <type_traits>
 #include <fstream>
+#include <vector>
+
+// Tolerance under which two coordinates are considered equal.
+const double POINT_EPS = 1e-9;
 
 // Return -1 if a < b, 0 if a = b and 1 if a > b.
-int cmp_double(double a, double b = 0, double eps = 1e-9);
+int cmp_double(double a, double b = 0, double eps = POINT_EPS);
 
 struct Point
 {
@@ -15,7 +20,97 @@ struct Point
     bool operator==(const Point &o) const;
 
     static std::vector<Point> generateRandomPointList(int n, int stdDev);
+    // Clustered cloud: both coordinates drawn from N(0, stdDev).
+    static std::vector<Point> generateNormalPointList(int n, int stdDev);
     static void createPointCloudFile(int n, std::vector<Point> pointList);
 };
 
+// Compare points on the cutting dimension, breaking ties on the other one.
+// The K-d trees order their nodes by it, so points sharing a coordinate still
+// split evenly.
+inline bool lessOnDim(const Point &a, const Point &b, int cutDim)
+{
+    if (a.coord[cutDim] != b.coord[cutDim])
+    {
+        return a.coord[cutDim] < b.coord[cutDim];
+    }
+    return a.coord[1 - cutDim] < b.coord[1 - cutDim];
+}
+
+// Non-owning view over a point cloud, read through strided coordinate
+// pointers of type Coord (double or float). A std::vector<Point> is viewed in
+// place (stride 2), separate x/y columns with stride 1. The column type is a
+// template parameter, so reading a coordinate is a plain load. The viewed
+// storage must outlive the view and every index built on it.
+template <typename Coord>
+struct BasicPointView
+{
+    const Coord *xs, *ys;
+    size_t stride;
+    size_t count;
+
+    BasicPointView() : xs(nullptr), ys(nullptr), stride(1), count(0) {}
+    BasicPointView(const Coord *xs, const Coord *ys, size_t count, size_t stride = 1)
+        : xs(xs), ys(ys), stride(stride), count(count) {}
+    // only a double view can look at Points in place
+    template <typename C = Coord, typename = typename std::enable_if<std::is_same<C, double>::value>::type>
+    BasicPointView(const std::vector<Point> &points) : BasicPointView(points.data(), points.size()) {}
+    template <typename C = Coord, typename = typename std::enable_if<std::is_same<C, double>::value>::type>
+    BasicPointView(const Point *points, size_t count)
+        : BasicPointView(count ? &points[0].coord[0] : nullptr, count ? &points[0].coord[1] : nullptr,
+                         count, sizeof(Point) / sizeof(double)) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    double x(size_t i) const { return xs[i * stride]; }
+    double y(size_t i) const { return ys[i * stride]; }
+    Point operator[](size_t i) const { return Point(x(i), y(i)); }
+
+    // The point as it reads back once stored in Coord columns. Searches round
+    // their queries with it, so a float view finds the double points it was
+    // filled from, and also any other query rounding to the same floats.
+    static Point round(const Point &p) { return Point((Coord) p.coord[0], (Coord) p.coord[1]); }
+};
+
+using PointView = BasicPointView<double>;
+using FloatPointView = BasicPointView<float>;
+
+// Non-owning view over a contiguous array, e.g. a std::vector or a
+// memory-mapped file. The viewed storage must outlive the view.
+template <typename T>
+struct ArrayView
+{
+    const T *data;
+    size_t count;
+
+    ArrayView() : data(nullptr), count(0) {}
+    ArrayView(const T *data, size_t count) : data(data), count(count) {}
+    ArrayView(const std::vector<T> &v) : data(v.data()), count(v.size()) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T &operator[](size_t i) const { return data[i]; }
+    const T *begin() const { return data; }
+    const T *end() const { return data + count; }
+};
+
+// Point cloud stored as separate x and y columns of type Coord.
+template <typename Coord>
+struct PointColumns
+{
+    std::vector<Coord> xs, ys;
+
+    PointColumns(const std::vector<Point> &points) : xs(points.size()), ys(points.size())
+    {
+        for (size_t i = 0; i < points.size(); i++)
+        {
+            xs[i] = points[i].coord[0];
+            ys[i] = points[i].coord[1];
+        }
+    }
+
+    BasicPointView<Coord> view() const { return BasicPointView<Coord>(xs.data(), ys.data(), xs.size()); }
+    size_t memoryBytes() const { return (xs.capacity() + ys.capacity()) * sizeof(Coord); }
+};
+
 #endif
\ No newline at end of file
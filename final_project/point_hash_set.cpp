@@ -0,0 +1,108 @@
+#include "point_hash_set.h"
+
+PointHashSet::PointHashSet(size_t expectedSize)
+{
+    size = 0;
+    // keep the table at most half full
+    size_t capacity = 16;
+    while (capacity < 2 * expectedSize) capacity *= 2;
+    table = std::vector<Slot>(capacity, Slot{Point(), -1});
+    mask = capacity - 1;
+}
+
+template <typename View>
+static void insertAll(PointHashSet &pointSet, const View &points)
+{
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        pointSet.insert(points[i], i);
+    }
+}
+
+PointHashSet::PointHashSet(const PointView &points) : PointHashSet(points.size())
+{
+    insertAll(*this, points);
+}
+
+PointHashSet::PointHashSet(const FloatPointView &points) : PointHashSet(points.size())
+{
+    insertAll(*this, points);
+}
+
+bool PointHashSet::insert(const Point &point, int index)
+{
+    if (find(point) != -1)
+    {
+        return false;
+    }
+    if (2 * (size + 1) > table.size())
+    {
+        rehash(2 * table.size());
+    }
+    // the point is stored under its own quantum only
+    size_t slot = homeSlot(quantize(point.coord[0]), quantize(point.coord[1]));
+    while (table[slot].index != -1)
+    {
+        slot = (slot + 1) & mask;
+    }
+    table[slot] = Slot{point, index < 0 ? (int) size : index};
+    size++;
+    return true;
+}
+
+int PointHashSet::findInQuantum(int64_t qx, int64_t qy, const Point &point) const
+{
+    for (size_t slot = homeSlot(qx, qy); table[slot].index != -1; slot = (slot + 1) & mask)
+    {
+        if (table[slot].point == point)
+        {
+            return table[slot].index;
+        }
+    }
+    return -1;
+}
+
+int PointHashSet::find(const Point &point) const
+{
+    // quanta touched by the square of points equal to point
+    int64_t x0 = quantize(point.coord[0] - POINT_EPS), x1 = quantize(point.coord[0] + POINT_EPS);
+    int64_t y0 = quantize(point.coord[1] - POINT_EPS), y1 = quantize(point.coord[1] + POINT_EPS);
+    for (int64_t qx = x0; qx <= x1; qx++)
+    {
+        for (int64_t qy = y0; qy <= y1; qy++)
+        {
+            int index = findInQuantum(qx, qy, point);
+            if (index != -1)
+            {
+                return index;
+            }
+        }
+    }
+    return -1;
+}
+
+void PointHashSet::clear()
+{
+    std::fill(table.begin(), table.end(), Slot{Point(), -1});
+    size = 0;
+}
+
+void PointHashSet::rehash(size_t capacity)
+{
+    std::vector<Slot> oldTable(capacity, Slot{Point(), -1});
+    std::swap(table, oldTable);
+    mask = capacity - 1;
+    for (auto &oldSlot : oldTable)
+    {
+        if (oldSlot.index == -1)
+        {
+            continue;
+        }
+        size_t slot = homeSlot(quantize(oldSlot.point.coord[0]), quantize(oldSlot.point.coord[1]));
+        while (table[slot].index != -1)
+        {
+            slot = (slot + 1) & mask;
+        }
+        table[slot] = oldSlot;
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef POINT_HASH_SET_H
+#define POINT_HASH_SET_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "point.h"
+
+// Exact-membership index for points under Point::operator==. Points are
+// hashed by their coordinates quantized to QUANTUM, much coarser than the
+// equality tolerance, and kept in an open-addressing table probed linearly.
+// A point equal to q lies in a quantum overlapping [q - eps, q + eps] on each
+// axis, which is almost always the quantum of q itself, so a lookup probes
+// one run of the table and rarely two or four.
+struct PointHashSet
+{
+    static constexpr double QUANTUM = 1e-6;
+
+    struct Slot
+    {
+        Point point;
+        // index of the point, -1 if the slot is empty
+        int index;
+    };
+
+    std::vector<Slot> table;
+    size_t mask;
+    size_t size;
+
+    PointHashSet(size_t expectedSize = 0);
+    PointHashSet(const PointView &points);
+    PointHashSet(const FloatPointView &points);
+
+    // Add the point unless an equal one is stored; false for a duplicate.
+    // An index of -1 is replaced by the number of points inserted before.
+    bool insert(const Point &point, int index);
+    // Index of the stored point equal to point, -1 if there is none.
+    int find(const Point &point) const;
+    bool contains(const Point &point) const { return find(point) != -1; }
+    void clear();
+    size_t memoryBytes() const { return table.capacity() * sizeof(Slot); }
+
+    // Quantum of v. It is clamped so the conversion stays defined for any v,
+    // NaN included; far-out points then share the edge quanta, which only
+    // lengthens their probe runs.
+    static int64_t quantize(double v)
+    {
+        const double QUANTUM_LIMIT = 9e18;
+        double q = std::floor(v * (1.0 / QUANTUM));
+        return (int64_t) std::max(-QUANTUM_LIMIT, std::min(q, QUANTUM_LIMIT));
+    }
+
+    // Slot where probing for the quantum (qx, qy) starts.
+    size_t homeSlot(int64_t qx, int64_t qy) const
+    {
+        // splitmix64 finalizer over both quantized coordinates
+        uint64_t h = (uint64_t) qx * 0x9e3779b97f4a7c15ULL ^ (uint64_t) qy;
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+        return h & mask;
+    }
+
+    int findInQuantum(int64_t qx, int64_t qy, const Point &point) const;
+    void rehash(size_t capacity);
+};
+
+#endif
@@ -0,0 +1,92 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include "point.h"
+#include "kd_tree.h"
+#include "bucket_kd_tree.h"
+#include "regular_grid/csr_regular_grid.h"
+#include "regular_grid/hash_regular_grid.h"
+#include "regular_grid/map_regular_grid.h"
+#include "regular_grid/matrix_regular_grid.h"
+
+const int STD_DEV = 1e2;
+const int NUM_QUERIES = 1e3;
+const double CELL_SIZE = 2.0;
+const int BUCKET_SIZE = 16;
+
+// Square windows covering the given fraction of the cloud's bounding box,
+// centered at random points of the box.
+std::vector<std::pair<Point, Point>> generateQueryWindows(int n, double selectivity)
+{
+    std::vector<std::pair<Point, Point>> result(n);
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> distribution(-400, 400);
+    double halfSide = std::sqrt(selectivity) * 800 / 2;
+    for (auto &window : result)
+    {
+        double x = distribution(generator);
+        double y = distribution(generator);
+        window = std::make_pair(Point(x - halfSide, y - halfSide), Point(x + halfSide, y + halfSide));
+    }
+    return result;
+}
+
+template <typename RangeFn>
+void benchmarkRangeSearch(const std::string &name, std::vector<std::pair<Point, Point>> &windows, RangeFn query)
+{
+    long long int numResults = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (auto &window : windows)
+    {
+        numResults += query(window.first, window.second).size();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double totalQueryTime = std::chrono::duration<double, std::micro>(end - begin).count();
+
+    std::cout << "  " << name << ": " << totalQueryTime/windows.size() << "[us] per query";
+    std::cout << " (" << (double) numResults/windows.size() << " points per query)\n";
+}
+
+int main()
+{
+    std::vector<double> randomPointCloudSize{1e4, 1e5, 1e6, 5*1e6};
+    std::vector<double> selectivities{1e-4, 1e-3, 1e-2, 1e-1};
+    for (int i : randomPointCloudSize)
+    {
+        std::cout << "n = " << i << '\n';
+        std::vector<Point> pointList = Point::generateRandomPointList(i, STD_DEV);
+        KDTree kdTree(pointList);
+        BucketKDTree bucketTree(pointList, BUCKET_SIZE);
+        MatrixRegularGrid matrixGrid(pointList, CELL_SIZE);
+        MapRegularGrid mapGrid(pointList, CELL_SIZE);
+        HashRegularGrid hashGrid(pointList, CELL_SIZE);
+        CSRRegularGrid csrGrid(pointList, CELL_SIZE);
+
+        for (double selectivity : selectivities)
+        {
+            std::cout << "Window covering " << selectivity * 100 << "% of the bounding box\n";
+            auto windows = generateQueryWindows(NUM_QUERIES, selectivity);
+            benchmarkRangeSearch("K-d tree", windows, [&](Point &lo, Point &hi) {
+                return kdTree.rangeSearch(lo, hi);
+            });
+            benchmarkRangeSearch("bucketed K-d tree", windows, [&](Point &lo, Point &hi) {
+                return bucketTree.rangeSearch(lo, hi);
+            });
+            benchmarkRangeSearch("matrix grid", windows, [&](Point &lo, Point &hi) {
+                return matrixGrid.rangeSearch(lo, hi);
+            });
+            benchmarkRangeSearch("std::map grid", windows, [&](Point &lo, Point &hi) {
+                return mapGrid.rangeSearch(lo, hi);
+            });
+            benchmarkRangeSearch("hash grid", windows, [&](Point &lo, Point &hi) {
+                return hashGrid.rangeSearch(lo, hi);
+            });
+            benchmarkRangeSearch("CSR grid", windows, [&](Point &lo, Point &hi) {
+                return csrGrid.rangeSearch(lo, hi);
+            });
+        }
+        std::cout << "------------------------------\n";
+    }
+    return 0;
+}
@@ -1,53 +1,444 @@
 #ifndef REGULAR_GRID_H
 #define REGULAR_GRID_H
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <limits>
 #include <map>
+#include <queue>
 #include <utility>
 #include <iostream>
 #include <vector>
+#include "../parallel.h"
 #include "../point.h"
 
 
-struct RegularGrid
+// Target used to pick the cell size from the point cloud.
+struct CellSizeOptions
 {
-    std::vector<Point> points;
+    double pointsPerCell;
+    // points sampled to estimate the occupied area, 0 to use the bounding box
+    int sampleSize;
+
+    explicit CellSizeOptions(double pointsPerCell = 2.0, int sampleSize = 0)
+        : pointsPerCell(pointsPerCell), sampleSize(sampleSize) {}
+};
+
+struct GridOccupancy
+{
+    long long int numCells, occupiedCells;
+    int maxChainLength;
+    double emptyCellRatio, averageChainLength;
+};
+
+// Grid over points stored as Coord (double or float) columns. The column type
+// is a template parameter so the cell scans read coordinates without a branch.
+template <typename Coord>
+struct BasicRegularGrid
+{
+    using View = BasicPointView<Coord>;
+    // not owned: the grid indexes the caller's points in place
+    View points;
     long long int gridSizeX, gridSizeY;
-    double cellSize, xmin, ymin, xmax, ymax;
+    // range of cell coordinates that may hold points; it only grows as
+    // points are added outside the original bounding box
+    int minCellX, minCellY, maxCellX, maxCellY;
+    double cellSize, invCellSize, xmin, ymin, xmax, ymax;
+    // next point in the same cell, for grids that chain their cells' points
     std::vector<int> cellPointsList;
+    // once the grid is modified it keeps its own copy of the points, x and y
+    // interleaved, and the view looks at it; slots of removed points are
+    // reused by addPoint
+    std::vector<Coord> ownedCoords;
+    bool ownsPoints = false;
+    std::vector<int> freeSlots;
+    // cellPointsList entry of a removed point
+    static const int REMOVED = -2;
 
-    RegularGrid(std::vector<Point>& _points, double _cellSize)
+    BasicRegularGrid(const View& _points, double _cellSize)
     {
         cellSize = _cellSize;
         points = _points;
-        cellPointsList = std::vector<int>(points.size(), -1);
+        computeBoundingBox();
+        computeGridSize();
+    }
+
+    BasicRegularGrid(const View& _points, double _cellSize, int numThreads)
+    {
+        cellSize = _cellSize;
+        points = _points;
+        computeBoundingBox(numThreads);
+        computeGridSize();
+    }
+
+    // Grid with a known bounding box, e.g. one saved with the grid's arrays.
+    BasicRegularGrid(const View& _points, double _cellSize, double _xmin, double _ymin, double _xmax, double _ymax)
+    {
+        cellSize = _cellSize;
+        points = _points;
+        xmin = _xmin;
+        ymin = _ymin;
+        xmax = _xmax;
+        ymax = _ymax;
+        computeGridSize();
+    }
+
+    BasicRegularGrid(const View& _points, const CellSizeOptions& options)
+    {
+        points = _points;
+        computeBoundingBox();
+        cellSize = chooseCellSize(options);
+        computeGridSize();
+    }
+
+    void computeBoundingBox(int numThreads = 1)
+    {
+        // every thread reduces its chunk into its own box, then the boxes are merged
+        numThreads = std::max(numThreads, 1);
+        std::vector<double> boxes(4 * numThreads);
+        parallelForChunks(numThreads, points.size(), [&](int t, size_t begin, size_t end)
+        {
+            double bxmin, bymin, bxmax, bymax;
+            bxmin = bymin = std::numeric_limits<double>::max();
+            bxmax = bymax = std::numeric_limits<double>::lowest();
+            for(size_t i=begin; i<end; i++)
+            {
+                double x = points.x(i);
+                double y = points.y(i);
+                bxmin = std::min(bxmin, x);
+                bxmax = std::max(bxmax, x);
+                bymin = std::min(bymin, y);
+                bymax = std::max(bymax, y);
+            }
+            boxes[4*t] = bxmin;
+            boxes[4*t+1] = bxmax;
+            boxes[4*t+2] = bymin;
+            boxes[4*t+3] = bymax;
+        });
 
-        // find bounding box
         xmin = ymin = std::numeric_limits<double>::max();
-        xmax = ymax = std::numeric_limits<double>::min();
-        for(auto& p : points)
+        xmax = ymax = std::numeric_limits<double>::lowest();
+        for(int t=0; t<numThreads; t++)
         {
-            xmin = std::min(xmin, p.coord[0]);
-            xmax = std::max(xmax, p.coord[0]);
-            ymin = std::min(ymin, p.coord[1]);
-            ymax = std::max(ymax, p.coord[1]);
+            xmin = std::min(xmin, boxes[4*t]);
+            xmax = std::max(xmax, boxes[4*t+1]);
+            ymin = std::min(ymin, boxes[4*t+2]);
+            ymax = std::max(ymax, boxes[4*t+3]);
         }
+    }
 
+    void computeGridSize()
+    {
+        // cell coordinates multiply by the inverse of the cell size; the grid
+        // size uses the same product so the farthest point lands in the last cell
+        invCellSize = 1.0 / cellSize;
         // saving width and height
-        gridSizeX = std::floor((xmax-xmin)/cellSize) + 1;
-        gridSizeY = std::floor((ymax-ymin)/cellSize) + 1;
+        gridSizeX = std::floor((xmax-xmin)*invCellSize) + 1;
+        gridSizeY = std::floor((ymax-ymin)*invCellSize) + 1;
+        minCellX = minCellY = 0;
+        maxCellX = gridSizeX - 1;
+        maxCellY = gridSizeY - 1;
     }
 
-    std::pair<int, int> getGridCoords(Point& point)
+    // Cell size giving options.pointsPerCell points per cell on average over
+    // the area the cloud occupies. Without sampling that area is the bounding
+    // box; with sampling it is the area of the coarse cells hit by the sample,
+    // which keeps skewed clouds from getting cells that are far too large.
+    double chooseCellSize(const CellSizeOptions& options)
     {
-        int xIdx = std::floor((point.coord[0]-xmin)/cellSize);
-        int yIdx = std::floor((point.coord[1]-ymin)/cellSize);
+        double width = std::max(xmax - xmin, 0.0);
+        double height = std::max(ymax - ymin, 0.0);
+        double area = width * height;
+        if (points.empty()) return 1.0;
+        if (area <= 0)
+        {
+            // points on a line (or a single point): spread them along its length
+            double length = std::max(width, height);
+            return length > 0 ? length * options.pointsPerCell / points.size() : 1.0;
+        }
+
+        int sampleSize = std::min<long long int>(options.sampleSize, points.size());
+        if (sampleSize > 0)
+        {
+            // coarse cells holding a few sample points each if the cloud were uniform
+            const double SAMPLE_POINTS_PER_CELL = 4.0;
+            double sampleCellSize = std::sqrt(area * SAMPLE_POINTS_PER_CELL / sampleSize);
+            std::vector<long long int> sampleCells(sampleSize);
+            size_t stride = points.size() / sampleSize;
+            long long int sampleGridSizeY = std::floor(height/sampleCellSize) + 1;
+            for(int i=0; i<sampleSize; i++)
+            {
+                Point p = points[i * stride];
+                long long int xIdx = std::floor((p.coord[0]-xmin)/sampleCellSize);
+                long long int yIdx = std::floor((p.coord[1]-ymin)/sampleCellSize);
+                sampleCells[i] = xIdx * sampleGridSizeY + yIdx;
+            }
+            std::sort(sampleCells.begin(), sampleCells.end());
+            long long int occupiedCells = std::unique(sampleCells.begin(), sampleCells.end()) - sampleCells.begin();
+            area = std::min(area, occupiedCells * sampleCellSize * sampleCellSize);
+        }
+        return std::sqrt(area * options.pointsPerCell / points.size());
+    }
+
+    // Cell statistics computed from the points, independent of how a grid stores its cells.
+    GridOccupancy getOccupancy()
+    {
+        GridOccupancy result;
+        // addPoint widens the cell range, and the matrix grid also allocates
+        // past it, so count whichever of the two is larger now
+        long long int rangeCells = (long long int) (maxCellX - minCellX + 1) * (maxCellY - minCellY + 1);
+        result.numCells = std::max(gridSizeX * gridSizeY, rangeCells);
+        result.occupiedCells = 0;
+        result.maxChainLength = 0;
+
+        std::vector<uint64_t> pointCells;
+        pointCells.reserve(points.size());
+        for(int i=0; i<points.size(); i++)
+        {
+            if (isRemoved(i)) continue;
+            auto gridCoords = getGridCoords(points[i]);
+            pointCells.push_back(((uint64_t) (uint32_t) gridCoords.first << 32) | (uint32_t) gridCoords.second);
+        }
+        std::sort(pointCells.begin(), pointCells.end());
+        for(size_t i=0, j=0; i<pointCells.size(); i=j)
+        {
+            while (j<pointCells.size() && pointCells[j] == pointCells[i]) j++;
+            result.occupiedCells++;
+            result.maxChainLength = std::max<int>(result.maxChainLength, j - i);
+        }
+        result.emptyCellRatio = 1.0 - (double) result.occupiedCells / result.numCells;
+        result.averageChainLength = result.occupiedCells ? (double) pointCells.size() / result.occupiedCells : 0;
+        return result;
+    }
+
+    std::pair<int, int> getGridCoords(const Point& point)
+    {
+        int xIdx = std::floor((point.coord[0]-xmin)*invCellSize);
+        int yIdx = std::floor((point.coord[1]-ymin)*invCellSize);
         return std::make_pair(xIdx, yIdx);
     }
 
+    bool isInsideRange(const Point& point, const Point& lo, const Point& hi)
+    {
+        return lo.coord[0] <= point.coord[0] && point.coord[0] <= hi.coord[0] &&
+               lo.coord[1] <= point.coord[1] && point.coord[1] <= hi.coord[1];
+    }
+
+    virtual ~BasicRegularGrid() {}
+    // Index of a point of cell (xIdx, yIdx) equal to point, -1 if there is none
+    // or the cell is outside the grid.
+    virtual int findPointInCell(int xIdx, int yIdx, const Point &point) = 0;
+
+    // Batched point location: out[i] is the index of a point equal to q[i],
+    // or -1. Each grid implements it with searchPointIndicesIn, so a whole
+    // batch costs one virtual call.
+    virtual void searchPointIndices(const Point* q, size_t n, int* out) = 0;
+
+    // Batch loop for grid type Grid. Queries are rounded to the stored
+    // precision and their cell coordinates computed for a block at a time in
+    // one branch-free loop the compiler can vectorize, then each cell is
+    // resolved with a direct, inlinable call to Grid's findPointInCell.
+    template <typename Grid>
+    void searchPointIndicesIn(const Point* q, size_t n, int* out)
+    {
+        Grid &grid = static_cast<Grid &>(*this);
+        const size_t BLOCK_SIZE = 256;
+        Point block[BLOCK_SIZE];
+        int xIdx[BLOCK_SIZE], yIdx[BLOCK_SIZE];
+        for(size_t blockBegin=0; blockBegin<n; blockBegin+=BLOCK_SIZE)
+        {
+            size_t blockSize = std::min(BLOCK_SIZE, n - blockBegin);
+            for(size_t j=0; j<blockSize; j++)
+            {
+                block[j] = View::round(q[blockBegin+j]);
+                xIdx[j] = std::floor((block[j].coord[0]-xmin)*invCellSize);
+                yIdx[j] = std::floor((block[j].coord[1]-ymin)*invCellSize);
+            }
+            for(size_t j=0; j<blockSize; j++)
+            {
+                out[blockBegin+j] = grid.Grid::findPointInCell(xIdx[j], yIdx[j], block[j]);
+            }
+        }
+    }
+
+    void searchPoints(const Point* q, size_t n, bool* out)
+    {
+        std::vector<int> indices(n);
+        searchPointIndices(q, n, indices.data());
+        for(size_t i=0; i<n; i++) out[i] = indices[i] != -1;
+    }
+
+    // Points are compared at the stored precision: on float columns a query
+    // is found when it rounds to the floats of a stored point.
+    bool searchPoint(Point &point)
+    {
+        Point query = View::round(point);
+        auto gridCoords = getGridCoords(query);
+        return findPointInCell(gridCoords.first, gridCoords.second, query) != -1;
+    }
+
+    // Add a point and return its index. Indices of removed points are reused.
+    // Grids that store cells densely grow when the point falls outside them;
+    // points already stored keep their cells, so nothing is rebuilt.
+    int addPoint(const Point& point)
+    {
+        if (!supportsUpdates())
+        {
+            std::cout << "ERROR: this grid cannot be modified after construction\n";
+            return -1;
+        }
+        ownPoints();
+        int pointIdx;
+        if (!freeSlots.empty())
+        {
+            pointIdx = freeSlots.back();
+            freeSlots.pop_back();
+            ownedCoords[2*pointIdx] = point.coord[0];
+            ownedCoords[2*pointIdx+1] = point.coord[1];
+        }
+        else
+        {
+            pointIdx = points.size();
+            ownedCoords.push_back(point.coord[0]);
+            ownedCoords.push_back(point.coord[1]);
+            cellPointsList.push_back(-1);
+            viewOwnedCoords();
+        }
+        auto gridCoords = getGridCoords(points[pointIdx]);
+        minCellX = std::min(minCellX, gridCoords.first);
+        maxCellX = std::max(maxCellX, gridCoords.first);
+        minCellY = std::min(minCellY, gridCoords.second);
+        maxCellY = std::max(maxCellY, gridCoords.second);
+        insertPoint(pointIdx);
+        return pointIdx;
+    }
+
+    // Remove the point with the given index; false if there is no such point.
+    bool removePoint(int pointIdx)
+    {
+        if (!supportsUpdates())
+        {
+            std::cout << "ERROR: this grid cannot be modified after construction\n";
+            return false;
+        }
+        if (pointIdx < 0 || pointIdx >= points.size() || isRemoved(pointIdx)) return false;
+        unlinkPoint(pointIdx);
+        cellPointsList[pointIdx] = REMOVED;
+        freeSlots.push_back(pointIdx);
+        return true;
+    }
+
+    bool isRemoved(int pointIdx)
+    {
+        return pointIdx < cellPointsList.size() && cellPointsList[pointIdx] == REMOVED;
+    }
+
+    // Copy the viewed points into ownedCoords so they can be modified.
+    void ownPoints()
+    {
+        if (ownsPoints) return;
+        ownedCoords = std::vector<Coord>(2 * points.size());
+        for(size_t i=0; i<points.size(); i++)
+        {
+            ownedCoords[2*i] = points.xs[i * points.stride];
+            ownedCoords[2*i+1] = points.ys[i * points.stride];
+        }
+        viewOwnedCoords();
+        ownsPoints = true;
+    }
+
+    void viewOwnedCoords()
+    {
+        size_t n = ownedCoords.size() / 2;
+        points = n ? View(&ownedCoords[0], &ownedCoords[1], n, 2) : View();
+    }
+
+    // Index of the point closest to q, -1 if the grid is empty.
+    int nearest(const Point &q)
+    {
+        std::vector<int> result = kNearest(q, 1);
+        return result.empty() ? -1 : result[0];
+    }
+
+    // Ring-expanding search over the cells around q's cell. forEachPointInCell(x, y, visit)
+    // must call visit(pointIdx, point) for every point of cell (x, y); each
+    // grid passes the walk over its own cell storage.
+    template <typename CellFn>
+    std::vector<int> kNearestInCells(const Point &q, int k, CellFn forEachPointInCell)
+    {
+        std::vector<int> result;
+        if (k <= 0 || points.size() == freeSlots.size()) return result;
+
+        // max-heap on squared distance holding the best k candidates
+        std::priority_queue<std::pair<double, int>> best;
+        auto visit = [&](int pointIdx, const Point &p)
+        {
+            double dx = p.coord[0] - q.coord[0];
+            double dy = p.coord[1] - q.coord[1];
+            double dist = dx * dx + dy * dy;
+            if (best.size() < k) best.emplace(dist, pointIdx);
+            else if (dist < best.top().first)
+            {
+                best.pop();
+                best.emplace(dist, pointIdx);
+            }
+        };
+
+        auto gridCoords = getGridCoords(q);
+        int cx = gridCoords.first, cy = gridCoords.second;
+        // every point of ring r is at least (r-1) cells plus the distance from
+        // q to the nearest side of its own cell away from q
+        double fx = q.coord[0] - (xmin + cx * cellSize);
+        double fy = q.coord[1] - (ymin + cy * cellSize);
+        double sideDist = std::max(0.0, std::min({fx, cellSize - fx, fy, cellSize - fy}));
+        // rings closer than the first one touching the occupied cells are empty
+        long long int firstRing = std::max({0LL, (long long int) minCellX - cx, (long long int) cx - maxCellX,
+                                            (long long int) minCellY - cy, (long long int) cy - maxCellY});
+        for(long long int r = firstRing; ; r++)
+        {
+            long long int x0 = std::max<long long int>(cx - r, minCellX), x1 = std::min<long long int>(cx + r, maxCellX);
+            long long int y0 = std::max<long long int>(cy - r, minCellY), y1 = std::min<long long int>(cy + r, maxCellY);
+            for(long long int x = x0; x <= x1; x++)
+            {
+                if (x == cx - r || x == cx + r)
+                {
+                    // left and right columns of the ring
+                    for(long long int y = y0; y <= y1; y++) forEachPointInCell(x, y, visit);
+                }
+                else
+                {
+                    // bottom and top cells of the ring
+                    if (cy - r >= minCellY) forEachPointInCell(x, cy - r, visit);
+                    if (r > 0 && cy + r <= maxCellY) forEachPointInCell(x, cy + r, visit);
+                }
+            }
+
+            bool coversGrid = cx - r <= minCellX && cx + r >= maxCellX && cy - r <= minCellY && cy + r >= maxCellY;
+            if (coversGrid) break;
+            double nextRingDist = r * cellSize + sideDist;
+            if (best.size() == k && nextRingDist * nextRingDist > best.top().first) break;
+        }
+
+        result.resize(best.size());
+        for(int i = (int) best.size() - 1; i >= 0; i--)
+        {
+            result[i] = best.top().second;
+            best.pop();
+        }
+        return result;
+    }
+
+    virtual bool supportsUpdates() { return true; }
+    // Take the point out of its cell's "linked list".
+    virtual void unlinkPoint(int pointIdx) = 0;
     virtual void insertPoint(int pointIdx) = 0;
-    virtual bool searchPoint(Point &point) = 0;
+    // Indices of every point inside the rectangle [lo.x, hi.x] x [lo.y, hi.y].
+    virtual std::vector<int> rangeSearch(const Point &lo, const Point &hi) = 0;
+    // Indices of the k points closest to q, from the nearest to the farthest.
+    virtual std::vector<int> kNearest(const Point &q, int k) = 0;
 };
 
+using RegularGrid = BasicRegularGrid<double>;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "csr_regular_grid.h"
+
+template <typename Coord>
+BasicCSRRegularGrid<Coord>::BasicCSRRegularGrid(const View& _points, double _cellSize)
+: Base(_points, _cellSize)
+{
+    buildGrid();
+}
+
+template <typename Coord>
+BasicCSRRegularGrid<Coord>::BasicCSRRegularGrid(const View& _points, const CellSizeOptions& options)
+: Base(_points, options)
+{
+    buildGrid();
+}
+
+template <typename Coord>
+BasicCSRRegularGrid<Coord>::BasicCSRRegularGrid(const View& _points, double _cellSize, int numThreads)
+: Base(_points, _cellSize, numThreads)
+{
+    buildGrid(numThreads);
+}
+
+template <typename Coord>
+BasicCSRRegularGrid<Coord>::BasicCSRRegularGrid(const View& _points, double _cellSize, double _xmin, double _ymin, double _xmax, double _ymax,
+                                                ArrayView<int> _cellStart, ArrayView<Point> _cellPoints, ArrayView<int> _cellPointIndices)
+: Base(_points, _cellSize, _xmin, _ymin, _xmax, _ymax),
+  cellStart(_cellStart), cellPoints(_cellPoints), cellPointIndices(_cellPointIndices)
+{
+}
+
+template <typename Coord>
+void BasicCSRRegularGrid<Coord>::buildGrid(int numThreads)
+{
+    numThreads = std::max(numThreads, 1);
+    size_t numCells = gridSizeX * gridSizeY;
+
+    // first pass: every thread counts the points of each cell in its chunk
+    std::vector<int> pointCell(points.size());
+    std::vector<std::vector<int>> threadCellFill(numThreads);
+    parallelForChunks(numThreads, points.size(), [&](int t, size_t begin, size_t end)
+    {
+        auto& cellCount = threadCellFill[t];
+        cellCount = std::vector<int>(numCells, 0);
+        for(size_t i=begin; i<end; i++)
+        {
+            auto gridCoords = getGridCoords(points[i]);
+            pointCell[i] = getCellIdx(gridCoords.first, gridCoords.second);
+            cellCount[pointCell[i]]++;
+        }
+    });
+
+    // prefix sum: within a cell, the points of thread t come before those of
+    // thread t+1, so each cell keeps its points in input order
+    ownedCellStart = std::vector<int>(numCells + 1);
+    int offset = 0;
+    for(size_t c=0; c<numCells; c++)
+    {
+        ownedCellStart[c] = offset;
+        for(int t=0; t<numThreads; t++)
+        {
+            int cellCount = threadCellFill[t][c];
+            threadCellFill[t][c] = offset;
+            offset += cellCount;
+        }
+    }
+    ownedCellStart[numCells] = offset;
+
+    // second pass: every thread scatters its chunk to its share of each cell
+    ownedCellPoints = std::vector<Point>(points.size());
+    ownedCellPointIndices = std::vector<int>(points.size());
+    parallelForChunks(numThreads, points.size(), [&](int t, size_t begin, size_t end)
+    {
+        auto& cellFill = threadCellFill[t];
+        for(size_t i=begin; i<end; i++)
+        {
+            int pos = cellFill[pointCell[i]]++;
+            ownedCellPoints[pos] = points[i];
+            ownedCellPointIndices[pos] = i;
+        }
+    });
+    cellStart = ArrayView<int>(ownedCellStart);
+    cellPoints = ArrayView<Point>(ownedCellPoints);
+    cellPointIndices = ArrayView<int>(ownedCellPointIndices);
+}
+
+// The grid is read-only: supportsUpdates() is false, so addPoint and
+// removePoint reject every update before reaching these.
+template <typename Coord>
+void BasicCSRRegularGrid<Coord>::insertPoint([[maybe_unused]] int pointIdx)
+{
+}
+
+template <typename Coord>
+void BasicCSRRegularGrid<Coord>::unlinkPoint([[maybe_unused]] int pointIdx)
+{
+}
+
+template <typename Coord>
+int BasicCSRRegularGrid<Coord>::findPointInCell(int xIdx, int yIdx, const Point &point)
+{
+    if(xIdx < 0 || yIdx < 0 || xIdx >= gridSizeX || yIdx >= gridSizeY)
+        return -1;
+
+    long long int cellIdx = getCellIdx(xIdx, yIdx);
+    for(int pos = cellStart[cellIdx]; pos < cellStart[cellIdx + 1]; pos++)
+    {
+        if (cellPoints[pos] == point) return cellPointIndices[pos];
+    }
+    return -1;
+}
+
+template <typename Coord>
+void BasicCSRRegularGrid<Coord>::searchPointIndices(const Point* q, size_t n, int* out)
+{
+    this->template searchPointIndicesIn<BasicCSRRegularGrid>(q, n, out);
+}
+
+template <typename Coord>
+std::vector<int> BasicCSRRegularGrid<Coord>::rangeSearch(const Point &lo, const Point &hi)
+{
+    std::vector<int> result;
+    auto loCoords = getGridCoords(lo);
+    auto hiCoords = getGridCoords(hi);
+    int x0 = std::max(loCoords.first, 0);
+    int y0 = std::max(loCoords.second, 0);
+    int x1 = std::min<long long int>(hiCoords.first, gridSizeX - 1);
+    int y1 = std::min<long long int>(hiCoords.second, gridSizeY - 1);
+    if (x0 > x1 || y0 > y1) return result;
+
+    for(int x = x0; x <= x1; x++)
+    {
+        // the cells of a column are consecutive, so scan the column's run at once
+        for(int pos = cellStart[getCellIdx(x, y0)]; pos < cellStart[getCellIdx(x, y1) + 1]; pos++)
+        {
+            if (isInsideRange(cellPoints[pos], lo, hi)) result.push_back(cellPointIndices[pos]);
+        }
+    }
+    return result;
+}
+
+template <typename Coord>
+std::vector<int> BasicCSRRegularGrid<Coord>::kNearest(const Point &q, int k)
+{
+    return kNearestInCells(q, k, [&](int x, int y, auto &visit)
+    {
+        long long int cellIdx = getCellIdx(x, y);
+        for(int pos = cellStart[cellIdx]; pos < cellStart[cellIdx + 1]; pos++)
+            visit(cellPointIndices[pos], cellPoints[pos]);
+    });
+}
+
+template struct BasicCSRRegularGrid<double>;
+template struct BasicCSRRegularGrid<float>;
@@ -0,0 +1,60 @@
+#ifndef CSR_REGULAR_GRID_H
+#define CSR_REGULAR_GRID_H
+
+#include "abstract_regular_grid.h"
+
+// Static grid in compressed sparse row layout: the points are counting-sorted
+// by cell, so the points of cell c are cellPoints[cellStart[c]..cellStart[c+1])
+// and sit next to each other in memory.
+template <typename Coord>
+struct BasicCSRRegularGrid : public BasicRegularGrid<Coord>
+{
+    using Base = BasicRegularGrid<Coord>;
+    using typename Base::View;
+    using Base::points;
+    using Base::gridSizeX;
+    using Base::gridSizeY;
+    using Base::getGridCoords;
+    using Base::isInsideRange;
+    using Base::kNearestInCells;
+
+    // cells are numbered row by row, cell (x, y) is x * gridSizeY + y
+    ArrayView<int> cellStart;
+    ArrayView<Point> cellPoints;
+    // index in points of each entry of cellPoints
+    ArrayView<int> cellPointIndices;
+    // storage of the arrays above for a grid built in memory, empty for a
+    // grid over external arrays
+    std::vector<int> ownedCellStart;
+    std::vector<Point> ownedCellPoints;
+    std::vector<int> ownedCellPointIndices;
+
+    BasicCSRRegularGrid(const View& _points, double _cellSize);
+    BasicCSRRegularGrid(const View& _points, const CellSizeOptions& options);
+    // Build with numThreads threads; the result is the same for any thread count.
+    BasicCSRRegularGrid(const View& _points, double _cellSize, int numThreads);
+    // Grid over cell arrays built elsewhere, e.g. mapped from a file by
+    // loadCSRRegularGrid; nothing is copied and the arrays must outlive the grid.
+    BasicCSRRegularGrid(const View& _points, double _cellSize, double _xmin, double _ymin, double _xmax, double _ymax,
+                        ArrayView<int> _cellStart, ArrayView<Point> _cellPoints, ArrayView<int> _cellPointIndices);
+    // a copy would keep viewing the source's arrays
+    BasicCSRRegularGrid(const BasicCSRRegularGrid&) = delete;
+    BasicCSRRegularGrid& operator=(const BasicCSRRegularGrid&) = delete;
+    void buildGrid(int numThreads = 1);
+    bool supportsUpdates() override { return false; }
+    void unlinkPoint(int pointIdx) override;
+    void insertPoint(int pointIdx) override;
+    int findPointInCell(int xIdx, int yIdx, const Point &point) override;
+    void searchPointIndices(const Point* q, size_t n, int* out) override;
+    std::vector<int> rangeSearch(const Point &lo, const Point &hi) override;
+    std::vector<int> kNearest(const Point &q, int k) override;
+
+    long long int getCellIdx(int xIdx, int yIdx) const
+    {
+        return (long long int) xIdx * gridSizeY + yIdx;
+    }
+};
+
+using CSRRegularGrid = BasicCSRRegularGrid<double>;
+
+#endif
@@ -1,43 +1,190 @@
 #include "hash_regular_grid.h"
 
-HashRegularGrid::HashRegularGrid(std::vector<Point>& _points, double _cellSize)
-    : RegularGrid(_points, _cellSize)
+template <typename Coord>
+BasicHashRegularGrid<Coord>::BasicHashRegularGrid(const View& _points, double _cellSize)
+    : Base(_points, _cellSize)
 {
+    buildGrid();
+}
+
+template <typename Coord>
+BasicHashRegularGrid<Coord>::BasicHashRegularGrid(const View& _points, const CellSizeOptions& options)
+    : Base(_points, options)
+{
+    buildGrid();
+}
+
+template <typename Coord>
+void BasicHashRegularGrid<Coord>::buildGrid()
+{
+    // there are at most as many non-empty cells as points or grid cells,
+    // keep the table at most half full
+    size_t maxCells = std::min<long long int>(points.size(), gridSizeX * gridSizeY);
+    size_t capacity = 16;
+    while (capacity < 2 * maxCells) capacity *= 2;
+    numCells = 0;
+    rehash(capacity);
+
+    cellPointsList = std::vector<int>(points.size(), -1);
     // insert points
     for(int i=0; i<points.size(); i++) insertPoint(i);
 }
 
-void HashRegularGrid::insertPoint(int pointIdx)
+template <typename Coord>
+void BasicHashRegularGrid<Coord>::rehash(size_t capacity)
 {
-    auto& point = points[pointIdx];
-    auto gridCoords = getGridCoords(point);
-    if(grid.count(gridCoords))
+    std::vector<Slot> oldGrid(capacity, Slot{0, -1});
+    std::swap(grid, oldGrid);
+    mask = capacity - 1;
+    for(auto& slot : oldGrid)
     {
-        // store the point in the "linked list" of that his cell
-        int nextPoint = grid[gridCoords];
-        grid[gridCoords] = pointIdx;
-        cellPointsList[pointIdx] = nextPoint;
+        if (slot.head != -1) grid[findSlot(slot.key)] = slot;
     }
-    else
+}
+
+template <typename Coord>
+void BasicHashRegularGrid<Coord>::insertPoint(int pointIdx)
+{
+    Point point = points[pointIdx];
+    auto gridCoords = getGridCoords(point);
+    uint64_t key = packCell(gridCoords.first, gridCoords.second);
+    size_t slot = findSlot(key);
+    if (grid[slot].head == -1)
     {
+        if (2 * (numCells + 1) > grid.size())
+        {
+            rehash(2 * grid.size());
+            slot = findSlot(key);
+        }
         // start a new "linked list" on this point's cell
-        grid[gridCoords] = pointIdx;
+        grid[slot] = Slot{key, pointIdx};
         cellPointsList[pointIdx] = -1;
+        numCells++;
+    }
+    else
+    {
+        // store the point in the "linked list" of that his cell
+        cellPointsList[pointIdx] = grid[slot].head;
+        grid[slot].head = pointIdx;
     }
 }
 
-bool HashRegularGrid::searchPoint(Point &point)
+template <typename Coord>
+void BasicHashRegularGrid<Coord>::unlinkPoint(int pointIdx)
 {
-    auto gridCoords = getGridCoords(point);
-    if (!grid.count(gridCoords)) return false;
-    
-    int pointIdx = grid[gridCoords];
-    if (points[pointIdx] == point) return true;
+    auto gridCoords = getGridCoords(points[pointIdx]);
+    size_t slot = findSlot(packCell(gridCoords.first, gridCoords.second));
+    if (grid[slot].head == -1) return;
+    if (grid[slot].head == pointIdx)
+    {
+        grid[slot].head = cellPointsList[pointIdx];
+        if (grid[slot].head == -1) eraseSlot(slot);
+        return;
+    }
+    for(int prevIdx = grid[slot].head; cellPointsList[prevIdx] != -1; prevIdx = cellPointsList[prevIdx])
+    {
+        if (cellPointsList[prevIdx] == pointIdx)
+        {
+            cellPointsList[prevIdx] = cellPointsList[pointIdx];
+            return;
+        }
+    }
+}
 
-    while(cellPointsList[pointIdx] != -1)
+template <typename Coord>
+void BasicHashRegularGrid<Coord>::eraseSlot(size_t slot)
+{
+    // backward-shift deletion: pull later entries of the probe run into the
+    // hole when the hole lies between their home slot and their position
+    size_t hole = slot;
+    for(size_t next = (slot + 1) & mask; grid[next].head != -1; next = (next + 1) & mask)
     {
-        pointIdx = cellPointsList[pointIdx];
-        if (points[pointIdx] == point) return true;
+        size_t home = homeSlot(grid[next].key);
+        bool homeAfterHole = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+        if (!homeAfterHole)
+        {
+            grid[hole] = grid[next];
+            hole = next;
+        }
     }
-    return false;
+    grid[hole].head = -1;
+    numCells--;
 }
+
+template <typename Coord>
+int BasicHashRegularGrid<Coord>::findPointInCell(int xIdx, int yIdx, const Point &point)
+{
+    for(int pointIdx = getCellHead(xIdx, yIdx); pointIdx != -1; pointIdx = cellPointsList[pointIdx])
+    {
+        if (points[pointIdx] == point) return pointIdx;
+    }
+    return -1;
+}
+
+template <typename Coord>
+void BasicHashRegularGrid<Coord>::searchPointIndices(const Point* q, size_t n, int* out)
+{
+    this->template searchPointIndicesIn<BasicHashRegularGrid>(q, n, out);
+}
+
+template <typename Coord>
+std::vector<int> BasicHashRegularGrid<Coord>::rangeSearch(const Point &lo, const Point &hi)
+{
+    std::vector<int> result;
+    auto loCoords = getGridCoords(lo);
+    auto hiCoords = getGridCoords(hi);
+    if (loCoords.first > hiCoords.first || loCoords.second > hiCoords.second) return result;
+
+    auto scanCell = [&](int x, int y, int pointIdx)
+    {
+        // cells strictly inside the window need no per-point test
+        bool interiorCell = loCoords.first < x && x < hiCoords.first &&
+                            loCoords.second < y && y < hiCoords.second;
+        for(; pointIdx != -1; pointIdx = cellPointsList[pointIdx])
+        {
+            if (interiorCell || isInsideRange(points[pointIdx], lo, hi)) result.push_back(pointIdx);
+        }
+    };
+
+    long long int coveredCells = (long long int) (hiCoords.first - loCoords.first + 1) *
+                                 (hiCoords.second - loCoords.second + 1);
+    if (coveredCells <= (long long int) numCells)
+    {
+        // look up each covered cell
+        for(int x = loCoords.first; x <= hiCoords.first; x++)
+        {
+            for(int y = loCoords.second; y <= hiCoords.second; y++)
+            {
+                int pointIdx = getCellHead(x, y);
+                if (pointIdx != -1) scanCell(x, y, pointIdx);
+            }
+        }
+    }
+    else
+    {
+        // the window covers more cells than are stored, walk the stored ones
+        for(auto& slot : grid)
+        {
+            if (slot.head == -1) continue;
+            int x = (int) (uint32_t) (slot.key >> 32);
+            int y = (int) (uint32_t) slot.key;
+            if (loCoords.first <= x && x <= hiCoords.first &&
+                loCoords.second <= y && y <= hiCoords.second)
+                scanCell(x, y, slot.head);
+        }
+    }
+    return result;
+}
+
+template <typename Coord>
+std::vector<int> BasicHashRegularGrid<Coord>::kNearest(const Point &q, int k)
+{
+    return kNearestInCells(q, k, [&](int x, int y, auto &visit)
+    {
+        for(int pointIdx = getCellHead(x, y); pointIdx != -1; pointIdx = cellPointsList[pointIdx])
+            visit(pointIdx, points[pointIdx]);
+    });
+}
+
+template struct BasicHashRegularGrid<double>;
+template struct BasicHashRegularGrid<float>;
@@ -1,15 +1,81 @@
 #ifndef HASH_REGULAR_GRID_H
-#define HASH_REGULAR_GRID_h
+#define HASH_REGULAR_GRID_H
 
+#include <cstdint>
 #include "abstract_regular_grid.h"
 
-struct HashRegularGrid : public RegularGrid
+// Grid whose non-empty cells are kept in an open-addressing hash table keyed
+// by the cell coordinates packed into 64 bits, probed linearly.
+template <typename Coord>
+struct BasicHashRegularGrid : public BasicRegularGrid<Coord>
 {
-    std::map<std::pair<int, int>, int> grid;
+    using Base = BasicRegularGrid<Coord>;
+    using typename Base::View;
+    using Base::points;
+    using Base::cellPointsList;
+    using Base::gridSizeX;
+    using Base::gridSizeY;
+    using Base::getGridCoords;
+    using Base::isInsideRange;
+    using Base::kNearestInCells;
 
-    HashRegularGrid(std::vector<Point>& _points, double _cellSize);
+    struct Slot
+    {
+        uint64_t key;
+        // first point of the cell's "linked list", -1 if the slot is empty
+        int head;
+    };
+
+    std::vector<Slot> grid;
+    size_t mask;
+    size_t numCells;
+
+    BasicHashRegularGrid(const View& _points, double _cellSize);
+    BasicHashRegularGrid(const View& _points, const CellSizeOptions& options);
+    void buildGrid();
     void insertPoint(int pointIdx) override;
-    bool searchPoint(Point &point) override;
+    void unlinkPoint(int pointIdx) override;
+    int findPointInCell(int xIdx, int yIdx, const Point &point) override;
+    void searchPointIndices(const Point* q, size_t n, int* out) override;
+    std::vector<int> rangeSearch(const Point &lo, const Point &hi) override;
+    std::vector<int> kNearest(const Point &q, int k) override;
+
+    static uint64_t packCell(int xIdx, int yIdx)
+    {
+        return ((uint64_t) (uint32_t) xIdx << 32) | (uint32_t) yIdx;
+    }
+
+    // Slot where probing for the key starts.
+    size_t homeSlot(uint64_t key) const
+    {
+        // splitmix64 finalizer: spreads neighbouring cells over the table
+        uint64_t h = key;
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+        return h & mask;
+    }
+
+    // Slot holding the cell, or the empty slot where it would be inserted.
+    size_t findSlot(uint64_t key) const
+    {
+        size_t slot = homeSlot(key);
+        while (grid[slot].head != -1 && grid[slot].key != key) slot = (slot + 1) & mask;
+        return slot;
+    }
+
+    // First point of the cell, -1 if the cell is empty.
+    int getCellHead(int xIdx, int yIdx) const
+    {
+        return grid[findSlot(packCell(xIdx, yIdx))].head;
+    }
+
+    void rehash(size_t capacity);
+    void eraseSlot(size_t slot);
 };
 
-#endif
\ No newline at end of file
+using HashRegularGrid = BasicHashRegularGrid<double>;
+
+#endif
@@ -0,0 +1,146 @@
+#include "map_regular_grid.h"
+
+template <typename Coord>
+BasicMapRegularGrid<Coord>::BasicMapRegularGrid(const View& _points, double _cellSize)
+    : Base(_points, _cellSize)
+{
+    buildGrid();
+}
+
+template <typename Coord>
+BasicMapRegularGrid<Coord>::BasicMapRegularGrid(const View& _points, const CellSizeOptions& options)
+    : Base(_points, options)
+{
+    buildGrid();
+}
+
+template <typename Coord>
+void BasicMapRegularGrid<Coord>::buildGrid()
+{
+    cellPointsList = std::vector<int>(points.size(), -1);
+    // insert points
+    for(int i=0; i<points.size(); i++) insertPoint(i);
+}
+
+template <typename Coord>
+void BasicMapRegularGrid<Coord>::insertPoint(int pointIdx)
+{
+    Point point = points[pointIdx];
+    auto gridCoords = getGridCoords(point);
+    if(grid.count(gridCoords))
+    {
+        // store the point in the "linked list" of that his cell
+        int nextPoint = grid[gridCoords];
+        grid[gridCoords] = pointIdx;
+        cellPointsList[pointIdx] = nextPoint;
+    }
+    else
+    {
+        // start a new "linked list" on this point's cell
+        grid[gridCoords] = pointIdx;
+        cellPointsList[pointIdx] = -1;
+    }
+}
+
+template <typename Coord>
+void BasicMapRegularGrid<Coord>::unlinkPoint(int pointIdx)
+{
+    auto it = grid.find(getGridCoords(points[pointIdx]));
+    if (it == grid.end()) return;
+    if (it->second == pointIdx)
+    {
+        if (cellPointsList[pointIdx] == -1) grid.erase(it);
+        else it->second = cellPointsList[pointIdx];
+        return;
+    }
+    for(int prevIdx = it->second; cellPointsList[prevIdx] != -1; prevIdx = cellPointsList[prevIdx])
+    {
+        if (cellPointsList[prevIdx] == pointIdx)
+        {
+            cellPointsList[prevIdx] = cellPointsList[pointIdx];
+            return;
+        }
+    }
+}
+
+template <typename Coord>
+int BasicMapRegularGrid<Coord>::findPointInCell(int xIdx, int yIdx, const Point &point)
+{
+    auto it = grid.find(std::make_pair(xIdx, yIdx));
+    if (it == grid.end()) return -1;
+
+    for(int pointIdx = it->second; pointIdx != -1; pointIdx = cellPointsList[pointIdx])
+    {
+        if (points[pointIdx] == point) return pointIdx;
+    }
+    return -1;
+}
+
+template <typename Coord>
+void BasicMapRegularGrid<Coord>::searchPointIndices(const Point* q, size_t n, int* out)
+{
+    this->template searchPointIndicesIn<BasicMapRegularGrid>(q, n, out);
+}
+
+template <typename Coord>
+std::vector<int> BasicMapRegularGrid<Coord>::rangeSearch(const Point &lo, const Point &hi)
+{
+    std::vector<int> result;
+    auto loCoords = getGridCoords(lo);
+    auto hiCoords = getGridCoords(hi);
+    if (loCoords.first > hiCoords.first || loCoords.second > hiCoords.second) return result;
+
+    auto scanCell = [&](const std::pair<int, int>& cell, int pointIdx)
+    {
+        // cells strictly inside the window need no per-point test
+        bool interiorCell = loCoords.first < cell.first && cell.first < hiCoords.first &&
+                            loCoords.second < cell.second && cell.second < hiCoords.second;
+        for(; pointIdx != -1; pointIdx = cellPointsList[pointIdx])
+        {
+            if (interiorCell || isInsideRange(points[pointIdx], lo, hi)) result.push_back(pointIdx);
+        }
+    };
+
+    long long int coveredCells = (long long int) (hiCoords.first - loCoords.first + 1) *
+                                 (hiCoords.second - loCoords.second + 1);
+    if (coveredCells <= (long long int) grid.size())
+    {
+        // look up each covered cell
+        for(int x = loCoords.first; x <= hiCoords.first; x++)
+        {
+            for(int y = loCoords.second; y <= hiCoords.second; y++)
+            {
+                auto cell = std::make_pair(x, y);
+                auto it = grid.find(cell);
+                if (it != grid.end()) scanCell(cell, it->second);
+            }
+        }
+    }
+    else
+    {
+        // the window covers more cells than are stored, walk the stored ones
+        for(auto& entry : grid)
+        {
+            const auto& cell = entry.first;
+            if (loCoords.first <= cell.first && cell.first <= hiCoords.first &&
+                loCoords.second <= cell.second && cell.second <= hiCoords.second)
+                scanCell(cell, entry.second);
+        }
+    }
+    return result;
+}
+
+template <typename Coord>
+std::vector<int> BasicMapRegularGrid<Coord>::kNearest(const Point &q, int k)
+{
+    return kNearestInCells(q, k, [&](int x, int y, auto &visit)
+    {
+        auto it = grid.find(std::make_pair(x, y));
+        if (it == grid.end()) return;
+        for(int pointIdx = it->second; pointIdx != -1; pointIdx = cellPointsList[pointIdx])
+            visit(pointIdx, points[pointIdx]);
+    });
+}
+
+template struct BasicMapRegularGrid<double>;
+template struct BasicMapRegularGrid<float>;
@@ -0,0 +1,33 @@
+#ifndef MAP_REGULAR_GRID_H
+#define MAP_REGULAR_GRID_H
+
+#include "abstract_regular_grid.h"
+
+// Grid whose non-empty cells are kept in a std::map keyed by cell coordinates.
+template <typename Coord>
+struct BasicMapRegularGrid : public BasicRegularGrid<Coord>
+{
+    using Base = BasicRegularGrid<Coord>;
+    using typename Base::View;
+    using Base::points;
+    using Base::cellPointsList;
+    using Base::getGridCoords;
+    using Base::isInsideRange;
+    using Base::kNearestInCells;
+
+    std::map<std::pair<int, int>, int> grid;
+
+    BasicMapRegularGrid(const View& _points, double _cellSize);
+    BasicMapRegularGrid(const View& _points, const CellSizeOptions& options);
+    void buildGrid();
+    void insertPoint(int pointIdx) override;
+    void unlinkPoint(int pointIdx) override;
+    int findPointInCell(int xIdx, int yIdx, const Point &point) override;
+    void searchPointIndices(const Point* q, size_t n, int* out) override;
+    std::vector<int> rangeSearch(const Point &lo, const Point &hi) override;
+    std::vector<int> kNearest(const Point &q, int k) override;
+};
+
+using MapRegularGrid = BasicMapRegularGrid<double>;
+
+#endif
\ No newline at end of file
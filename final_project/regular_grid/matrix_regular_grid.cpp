@@ -1,19 +1,37 @@
 #include "matrix_regular_grid.h"
 
 
-MatrixRegularGrid::MatrixRegularGrid(std::vector<Point>& _points, double _cellSize)
-: RegularGrid(_points, _cellSize)
+template <typename Coord>
+BasicMatrixRegularGrid<Coord>::BasicMatrixRegularGrid(const View& _points, double _cellSize, CellLayout _layout)
+: Base(_points, _cellSize), layout(_layout)
 {
-    grid = std::vector<std::vector<int>>(gridSizeX, std::vector<int>(gridSizeY, -1));
+    buildGrid();
+}
+
+template <typename Coord>
+BasicMatrixRegularGrid<Coord>::BasicMatrixRegularGrid(const View& _points, const CellSizeOptions& options, CellLayout _layout)
+: Base(_points, options), layout(_layout)
+{
+    buildGrid();
+}
+
+template <typename Coord>
+void BasicMatrixRegularGrid<Coord>::buildGrid()
+{
+    originX = originY = 0;
+    grid = std::vector<int32_t>(getArraySize(gridSizeX, gridSizeY), -1);
+    cellPointsList = std::vector<int>(points.size(), -1);
     // insert points
     for(int i=0; i<points.size(); i++) insertPoint(i);
 }
 
-void MatrixRegularGrid::insertPoint(int pointIdx)
+template <typename Coord>
+void BasicMatrixRegularGrid<Coord>::insertPoint(int pointIdx)
 {
-    auto& point = points[pointIdx];
+    Point point = points[pointIdx];
     auto gridCoords = getGridCoords(point);
-    auto& gridCell = grid[gridCoords.first][gridCoords.second];
+    if (!isInsideGrid(gridCoords.first, gridCoords.second)) growToCell(gridCoords.first, gridCoords.second);
+    auto& gridCell = grid[getCellIdx(gridCoords.first, gridCoords.second)];
     if(gridCell != -1)
     {
         // store the point in the "linked list" of that his cell
@@ -29,23 +47,113 @@ void MatrixRegularGrid::insertPoint(int pointIdx)
     }
 }
 
-bool MatrixRegularGrid::searchPoint(Point &point)
+template <typename Coord>
+void BasicMatrixRegularGrid<Coord>::unlinkPoint(int pointIdx)
 {
-    auto gridCoords = getGridCoords(point);
-    if(gridCoords.first < 0 || gridCoords.second < 0 ||
-        gridCoords.first >= gridSizeX || gridCoords.second >= gridSizeY)
-        return false;
-    
-    auto& gridCell = grid[gridCoords.first][gridCoords.second];
-    if (gridCell == -1) return false;
-    
-    int pointIdx = gridCell;
-    if (points[pointIdx] == point) return true;
-
-    while(cellPointsList[pointIdx] != -1)
-    {
-        pointIdx = cellPointsList[pointIdx];
-        if (points[pointIdx] == point) return true;
+    auto gridCoords = getGridCoords(points[pointIdx]);
+    if (!isInsideGrid(gridCoords.first, gridCoords.second)) return;
+    auto& gridCell = grid[getCellIdx(gridCoords.first, gridCoords.second)];
+    if (gridCell == pointIdx)
+    {
+        gridCell = cellPointsList[pointIdx];
+        return;
+    }
+    for(int prevIdx = gridCell; prevIdx != -1 && cellPointsList[prevIdx] != -1; prevIdx = cellPointsList[prevIdx])
+    {
+        if (cellPointsList[prevIdx] == pointIdx)
+        {
+            cellPointsList[prevIdx] = cellPointsList[pointIdx];
+            return;
+        }
+    }
+}
+
+template <typename Coord>
+void BasicMatrixRegularGrid<Coord>::growToCell(int xIdx, int yIdx)
+{
+    // extend each side that must grow by at least the current size, so a
+    // drifting domain costs amortized O(1) cell copies per added point
+    long long int newOriginX = originX, newEndX = originX + gridSizeX;
+    long long int newOriginY = originY, newEndY = originY + gridSizeY;
+    if (xIdx < newOriginX) newOriginX = std::min<long long int>(xIdx, originX - gridSizeX);
+    if (xIdx >= newEndX) newEndX = std::max<long long int>(xIdx + 1, newEndX + gridSizeX);
+    if (yIdx < newOriginY) newOriginY = std::min<long long int>(yIdx, originY - gridSizeY);
+    if (yIdx >= newEndY) newEndY = std::max<long long int>(yIdx + 1, newEndY + gridSizeY);
+
+    long long int newSizeX = newEndX - newOriginX;
+    long long int newSizeY = newEndY - newOriginY;
+    std::vector<int32_t> newGrid(getArraySize(newSizeX, newSizeY), -1);
+    // move the cell heads; the points' "linked lists" stay as they are
+    for(int x = 0; x < gridSizeX; x++)
+    {
+        for(int y = 0; y < gridSizeY; y++)
+        {
+            int head = grid[getArrayIdx(x, y, gridSizeY)];
+            if (head != -1) newGrid[getArrayIdx(x + originX - newOriginX, y + originY - newOriginY, newSizeY)] = head;
+        }
+    }
+    grid.swap(newGrid);
+    originX = newOriginX;
+    originY = newOriginY;
+    gridSizeX = newSizeX;
+    gridSizeY = newSizeY;
+}
+
+template <typename Coord>
+int BasicMatrixRegularGrid<Coord>::findPointInCell(int xIdx, int yIdx, const Point &point)
+{
+    if(!isInsideGrid(xIdx, yIdx))
+        return -1;
+
+    for(int pointIdx = grid[getCellIdx(xIdx, yIdx)]; pointIdx != -1; pointIdx = cellPointsList[pointIdx])
+    {
+        if (points[pointIdx] == point) return pointIdx;
+    }
+    return -1;
+}
+
+template <typename Coord>
+void BasicMatrixRegularGrid<Coord>::searchPointIndices(const Point* q, size_t n, int* out)
+{
+    this->template searchPointIndicesIn<BasicMatrixRegularGrid>(q, n, out);
+}
+
+template <typename Coord>
+std::vector<int> BasicMatrixRegularGrid<Coord>::rangeSearch(const Point &lo, const Point &hi)
+{
+    std::vector<int> result;
+    auto loCoords = getGridCoords(lo);
+    auto hiCoords = getGridCoords(hi);
+    int x0 = std::max(loCoords.first, originX);
+    int y0 = std::max(loCoords.second, originY);
+    int x1 = std::min<long long int>(hiCoords.first, originX + gridSizeX - 1);
+    int y1 = std::min<long long int>(hiCoords.second, originY + gridSizeY - 1);
+
+    for(int x = x0; x <= x1; x++)
+    {
+        for(int y = y0; y <= y1; y++)
+        {
+            // cells strictly inside the window need no per-point test
+            bool interiorCell = loCoords.first < x && x < hiCoords.first &&
+                                loCoords.second < y && y < hiCoords.second;
+            for(int pointIdx = grid[getCellIdx(x, y)]; pointIdx != -1; pointIdx = cellPointsList[pointIdx])
+            {
+                if (interiorCell || isInsideRange(points[pointIdx], lo, hi)) result.push_back(pointIdx);
+            }
+        }
     }
-    return false;
+    return result;
 }
+
+template <typename Coord>
+std::vector<int> BasicMatrixRegularGrid<Coord>::kNearest(const Point &q, int k)
+{
+    return kNearestInCells(q, k, [&](int x, int y, auto &visit)
+    {
+        for(int pointIdx = grid[getCellIdx(x, y)]; pointIdx != -1; pointIdx = cellPointsList[pointIdx])
+            visit(pointIdx, points[pointIdx]);
+    });
+}
+
+template struct BasicMatrixRegularGrid<double>;
+template struct BasicMatrixRegularGrid<float>;
@@ -1,15 +1,96 @@
 #ifndef MATRIX_REGULAR_GRID_H
-#define MATRIX_REGULAR_GRID_h
+#define MATRIX_REGULAR_GRID_H
 
+#include <cstdint>
 #include "abstract_regular_grid.h"
 
-struct MatrixRegularGrid : public RegularGrid
+// Order of the cells in the flat cell array: row by row, or in square tiles
+// of ZORDER_TILE x ZORDER_TILE cells laid out row by row, each tile ordered
+// along a Z-order (Morton) curve so cells that are close in the plane are
+// close in memory. Tiling keeps the padding below one tile per side, where
+// a single Morton curve over an elongated grid would need the square of
+// its longest side.
+enum class CellLayout { RowMajor, ZOrder };
+
+const int ZORDER_TILE_BITS = 4;
+const int ZORDER_TILE = 1 << ZORDER_TILE_BITS;
+
+template <typename Coord>
+struct BasicMatrixRegularGrid : public BasicRegularGrid<Coord>
 {
-    std::vector<std::vector<int>> grid;
+    using Base = BasicRegularGrid<Coord>;
+    using typename Base::View;
+    using Base::points;
+    using Base::cellPointsList;
+    using Base::gridSizeX;
+    using Base::gridSizeY;
+    using Base::getGridCoords;
+    using Base::isInsideRange;
+    using Base::kNearestInCells;
+
+    CellLayout layout;
+    // first point of each cell's "linked list", -1 for empty cells
+    std::vector<int32_t> grid;
+    // cell coordinates of the first column and row of the array; they drop
+    // below 0 when points are added left of or below the original box
+    int originX, originY;
 
-    MatrixRegularGrid(std::vector<Point>& _points, double _cellSize);
+    BasicMatrixRegularGrid(const View& _points, double _cellSize, CellLayout _layout = CellLayout::RowMajor);
+    BasicMatrixRegularGrid(const View& _points, const CellSizeOptions& options, CellLayout _layout = CellLayout::RowMajor);
+    void buildGrid();
     void insertPoint(int pointIdx) override;
-    bool searchPoint(Point &point) override;
+    void unlinkPoint(int pointIdx) override;
+    void growToCell(int xIdx, int yIdx);
+    int findPointInCell(int xIdx, int yIdx, const Point &point) override;
+    void searchPointIndices(const Point* q, size_t n, int* out) override;
+    std::vector<int> rangeSearch(const Point &lo, const Point &hi) override;
+    std::vector<int> kNearest(const Point &q, int k) override;
+
+    bool isInsideGrid(int xIdx, int yIdx) const
+    {
+        return xIdx >= originX && yIdx >= originY && xIdx - originX < gridSizeX && yIdx - originY < gridSizeY;
+    }
+
+    size_t getCellIdx(int xIdx, int yIdx) const
+    {
+        return getArrayIdx(xIdx - originX, yIdx - originY, gridSizeY);
+    }
+
+    // Position in the array of the cell in column x and row y of the array.
+    size_t getArrayIdx(int x, int y, long long int sizeY) const
+    {
+        if (layout == CellLayout::RowMajor) return (size_t) x * sizeY + y;
+        size_t tilesY = (sizeY + ZORDER_TILE - 1) / ZORDER_TILE;
+        size_t tile = (size_t) (x >> ZORDER_TILE_BITS) * tilesY + (y >> ZORDER_TILE_BITS);
+        return tile * ZORDER_TILE * ZORDER_TILE + mortonCode(x & (ZORDER_TILE - 1), y & (ZORDER_TILE - 1));
+    }
+
+    // Number of entries of the array for sizeX columns and sizeY rows.
+    size_t getArraySize(long long int sizeX, long long int sizeY) const
+    {
+        if (layout == CellLayout::RowMajor) return (size_t) sizeX * sizeY;
+        size_t tilesX = (sizeX + ZORDER_TILE - 1) / ZORDER_TILE;
+        size_t tilesY = (sizeY + ZORDER_TILE - 1) / ZORDER_TILE;
+        return tilesX * tilesY * ZORDER_TILE * ZORDER_TILE;
+    }
+
+    // Interleave the bits of x and y: x takes the even bits, y the odd ones.
+    static uint64_t mortonCode(uint32_t x, uint32_t y)
+    {
+        return spreadBits(x) | (spreadBits(y) << 1);
+    }
+
+    static uint64_t spreadBits(uint64_t v)
+    {
+        v = (v | (v << 16)) & 0x0000ffff0000ffffULL;
+        v = (v | (v << 8)) & 0x00ff00ff00ff00ffULL;
+        v = (v | (v << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+        v = (v | (v << 2)) & 0x3333333333333333ULL;
+        v = (v | (v << 1)) & 0x5555555555555555ULL;
+        return v;
+    }
 };
 
+using MatrixRegularGrid = BasicMatrixRegularGrid<double>;
+
 #endif
\ No newline at end of file
@@ -1,53 +1,248 @@
 #include <chrono>
 #include <iostream>
+#include <memory>
 #include <algorithm>
+#include <string>
+#include <thread>
 #include "point.h"
+#include "point_hash_set.h"
+#include "index_io.h"
+#include "regular_grid/csr_regular_grid.h"
 #include "regular_grid/hash_regular_grid.h"
+#include "regular_grid/map_regular_grid.h"
 #include "regular_grid/matrix_regular_grid.h"
 
 
 const int STD_DEV = 1e2;
+const double CELL_SIZE = 2.0;
+const double POINTS_PER_CELL = 2.0;
+const int DENSITY_SAMPLE_SIZE = 1e4;
+
+// Search every other point of the list and a shifted copy of it, so half
+// of the queries hit and half miss.
+template <typename SearchFn>
+void benchmarkPointSearch(const std::string &name, std::vector<Point> &pointList, SearchFn search)
+{
+    int numPointInList = 0;
+    int numPointNotInList = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < pointList.size(); i += 2)
+    {
+        Point modifiedPoint = pointList[i];
+        modifiedPoint.coord[0] += 0.5;
+        modifiedPoint.coord[1] += 0.5;
+        if(search(pointList[i])) numPointInList++;
+        else numPointNotInList++;
+
+        if(search(modifiedPoint)) numPointInList++;
+        else numPointNotInList++;
+    }
+    auto end = std::chrono::steady_clock::now();
+    double totalSearchTime = std::chrono::duration<double, std::milli>(end - begin).count();
+
+    std::cout << "Average point-search time (" << name << ") = " << totalSearchTime/pointList.size() << "[ms]\n";
+    std::cout << "Number of points in list = " << numPointInList << '\n';
+    std::cout << "Number of points not in list = " << numPointNotInList << '\n';
+}
+
+// Compare the scalar searchPoint loop with searchPoints on the same queries.
+template <typename Coord>
+void benchmarkBatchSearch(const std::string &name, std::vector<Point> &pointList, BasicRegularGrid<Coord> &grid)
+{
+    std::vector<Point> queries;
+    queries.reserve(pointList.size());
+    for (int i = 0; i < pointList.size(); i += 2)
+    {
+        Point modifiedPoint = pointList[i];
+        modifiedPoint.coord[0] += 0.5;
+        modifiedPoint.coord[1] += 0.5;
+        queries.push_back(pointList[i]);
+        queries.push_back(modifiedPoint);
+    }
+
+    int numFoundScalar = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (auto &q : queries)
+    {
+        if (grid.searchPoint(q)) numFoundScalar++;
+    }
+    auto end = std::chrono::steady_clock::now();
+    double scalarTime = std::chrono::duration<double>(end - begin).count();
+
+    std::unique_ptr<bool[]> found(new bool[queries.size()]);
+    begin = std::chrono::steady_clock::now();
+    grid.searchPoints(queries.data(), queries.size(), found.get());
+    end = std::chrono::steady_clock::now();
+    double batchTime = std::chrono::duration<double>(end - begin).count();
+    int numFoundBatch = std::count(found.get(), found.get() + queries.size(), true);
+
+    std::cout << "Search throughput (" << name << ") = " << queries.size() / scalarTime << " points/s scalar, ";
+    std::cout << queries.size() / batchTime << " points/s batched";
+    std::cout << (numFoundScalar == numFoundBatch ? "" : " (MISMATCH)") << '\n';
+}
+
+template <typename Grid, typename... Args>
+void benchmarkGrid(const std::string &name, std::vector<Point> &pointList, Args... args)
+{
+    auto begin = std::chrono::steady_clock::now();
+    Grid grid(pointList, CELL_SIZE, args...);
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "Construct grid time (" << name << ") = " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms]\n";
+
+    benchmarkPointSearch(name, pointList, [&](Point &p) { return grid.searchPoint(p); });
+    benchmarkBatchSearch(name, pointList, grid);
+}
+
+// Replace points one by one while querying: every round removes a random
+// point, adds one from a slightly larger square (so the domain grows) and
+// searches for a stored point and for a missing one.
+template <typename Grid, typename... Args>
+void benchmarkChurn(const std::string &name, std::vector<Point> &pointList, Args... args)
+{
+    Grid grid(pointList, CELL_SIZE, args...);
+    std::vector<int> aliveIds(pointList.size());
+    for (int i = 0; i < pointList.size(); i++) aliveIds[i] = i;
+
+    std::mt19937 generator(11);
+    std::uniform_real_distribution<double> distribution(-440, 440);
+    int numRounds = pointList.size();
+    int numFound = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < numRounds; round++)
+    {
+        int pos = generator() % aliveIds.size();
+        grid.removePoint(aliveIds[pos]);
+        aliveIds[pos] = grid.addPoint(Point(distribution(generator), distribution(generator)));
+
+        Point storedPoint = grid.points[aliveIds[generator() % aliveIds.size()]];
+        Point missingPoint = storedPoint;
+        missingPoint.coord[0] += 0.5;
+        if (grid.searchPoint(storedPoint)) numFound++;
+        if (grid.searchPoint(missingPoint)) numFound++;
+    }
+    auto end = std::chrono::steady_clock::now();
+    double totalTime = std::chrono::duration<double, std::micro>(end - begin).count();
+    std::cout << "Churn (" << name << ") = " << totalTime / numRounds << "[us] per remove+add+2 searches";
+    std::cout << ", found " << numFound << "/" << 2 * numRounds << '\n';
+}
+
+// Build grids with the cell size picked from the cloud and log what was chosen.
+void benchmarkAutoCellSize(const std::string &name, std::vector<Point> &pointList, const CellSizeOptions &options)
+{
+    auto begin = std::chrono::steady_clock::now();
+    HashRegularGrid grid(pointList, options);
+    auto end = std::chrono::steady_clock::now();
+    GridOccupancy occupancy = grid.getOccupancy();
+    std::cout << "Automatic cell size (" << name << ") = " << grid.cellSize;
+    std::cout << ", construct time = " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms]\n";
+    std::cout << "  occupied cells = " << occupancy.occupiedCells << "/" << occupancy.numCells;
+    std::cout << ", empty-cell ratio = " << occupancy.emptyCellRatio;
+    std::cout << ", max chain length = " << occupancy.maxChainLength;
+    std::cout << ", average chain length = " << occupancy.averageChainLength << '\n';
+    benchmarkPointSearch(name, pointList, [&](Point &p) { return grid.searchPoint(p); });
+}
+
+// Time the CSR build for growing thread counts and check it matches the serial build.
+void benchmarkParallelBuild(std::vector<Point> &pointList)
+{
+    int maxThreads = std::max<int>(std::thread::hardware_concurrency(), 1);
+    CSRRegularGrid serialGrid(pointList, CELL_SIZE);
+    double serialTime = 0;
+    for (int numThreads = 1; ; numThreads = std::min(2 * numThreads, maxThreads))
+    {
+        auto begin = std::chrono::steady_clock::now();
+        CSRRegularGrid grid(pointList, CELL_SIZE, numThreads);
+        auto end = std::chrono::steady_clock::now();
+        double buildTime = std::chrono::duration<double, std::milli>(end - begin).count();
+        if (numThreads == 1) serialTime = buildTime;
+
+        bool sameAsSerial = grid.ownedCellStart == serialGrid.ownedCellStart &&
+                            grid.ownedCellPointIndices == serialGrid.ownedCellPointIndices;
+        std::cout << "Construct grid time (CSR, " << numThreads << " threads) = " << buildTime << "[ms]";
+        std::cout << ", speedup = " << serialTime / buildTime;
+        std::cout << ", same as serial = " << (sameAsSerial ? "yes" : "NO") << '\n';
+        if (numThreads == maxThreads) break;
+    }
+}
+
+// Index the cloud through x/y columns of type Coord instead of the vector of
+// points. The original double points are searched, so float columns must
+// still find every one of them.
+template <typename Coord>
+void benchmarkColumnStorage(const std::string &name, std::vector<Point> &pointList)
+{
+    PointColumns<Coord> columns(pointList);
+    std::cout << "Point storage (" << name << ") = " << columns.memoryBytes() << " bytes, ";
+    std::cout << pointList.size() * sizeof(Point) << " bytes as a vector of points\n";
+
+    auto begin = std::chrono::steady_clock::now();
+    BasicHashRegularGrid<Coord> grid(columns.view(), CELL_SIZE);
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "Construct grid time (" << name << ") = " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms]\n";
+    benchmarkPointSearch(name, pointList, [&](Point &p) { return grid.searchPoint(p); });
+    benchmarkBatchSearch(name, pointList, grid);
+}
+
+// Membership answered by the quantized-coordinate hash set, with no cell walk.
+void benchmarkPointHashSet(std::vector<Point> &pointList)
+{
+    auto begin = std::chrono::steady_clock::now();
+    PointHashSet pointSet(pointList);
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "Construct hash set time = " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms]\n";
+    benchmarkPointSearch("hash set", pointList, [&](Point &p) { return pointSet.contains(p); });
+}
+
+// Save a CSR grid and time how long the mapped copy takes to be queryable.
+void benchmarkIndexFile(std::vector<Point> &pointList)
+{
+    std::string indexPath = "csrGrid" + std::to_string(pointList.size()) + ".idx";
+    {
+        CSRRegularGrid grid(pointList, CELL_SIZE);
+        saveCSRRegularGrid(grid, indexPath);
+    }
+    auto begin = std::chrono::steady_clock::now();
+    {
+        MappedFile indexFile(indexPath);
+        auto grid = loadCSRRegularGrid(indexFile);
+        auto end = std::chrono::steady_clock::now();
+        std::cout << "Load grid time (CSR, mapped) = " << std::chrono::duration<double, std::milli>(end - begin).count() << "[ms]\n";
+        if (grid) benchmarkPointSearch("CSR, mapped", pointList, [&](Point &p) { return grid->searchPoint(p); });
+    }
+    std::remove(indexPath.c_str());
+}
 
 int main()
 {
     srand(42);
-    std::chrono::steady_clock::time_point begin;
-    std::chrono::steady_clock::time_point end;
 
     std::vector<double> randomPointCloudSize{1e3, 5*1e3, 1e4, 5*1e4, 1e5, 5*1e5, 1e6, 5*1e6};
     for (int i : randomPointCloudSize)
     {
         std::cout << "n = " << i << '\n';
         std::vector<Point> pointList = Point::generateRandomPointList(i, STD_DEV);
-        
-        begin = std::chrono::steady_clock::now();
-        MatrixRegularGrid grid(pointList, 2.0);
-        end = std::chrono::steady_clock::now();
-        
-        std::cout << "Construct grid time = " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms]\n";
-
-        int numPointInList = 0;
-        int numPointNotInList = 0;
-        begin = std::chrono::steady_clock::now();
-        for (int i = 0; i < pointList.size(); i += 2)
-        {
-            Point modifiedPoint = pointList[i];
-            modifiedPoint.coord[0] += 0.5;
-            modifiedPoint.coord[1] += 0.5;
-            if(grid.searchPoint(pointList[i])) numPointInList++;
-            else numPointNotInList++;
-            
-            if(grid.searchPoint(modifiedPoint)) numPointInList++;
-            else numPointNotInList++; 
-        }
-        end = std::chrono::steady_clock::now();
-        double totalSearchTime = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
-
-        std::cout << "Average point-search time = " << totalSearchTime/pointList.size() << "[ms]\n";
-        std::cout << "Number of points in list = " << numPointInList << '\n';
-        std::cout << "Number of points not in list = " << numPointNotInList << '\n';
+
+        benchmarkGrid<MatrixRegularGrid>("matrix", pointList);
+        benchmarkGrid<MatrixRegularGrid>("matrix, Z-order", pointList, CellLayout::ZOrder);
+        benchmarkGrid<MapRegularGrid>("std::map", pointList);
+        benchmarkGrid<HashRegularGrid>("hash", pointList);
+        benchmarkGrid<CSRRegularGrid>("CSR", pointList);
+        benchmarkPointHashSet(pointList);
+        benchmarkIndexFile(pointList);
+        benchmarkParallelBuild(pointList);
+        benchmarkChurn<MatrixRegularGrid>("matrix", pointList);
+        benchmarkChurn<HashRegularGrid>("hash", pointList);
+        benchmarkColumnStorage<double>("hash, double columns", pointList);
+        benchmarkColumnStorage<float>("hash, float columns", pointList);
+
+        std::cout << "Normal distribution cloud\n";
+        std::vector<Point> normalPointList = Point::generateNormalPointList(i, STD_DEV);
+        benchmarkGrid<MatrixRegularGrid>("matrix", normalPointList);
+        benchmarkGrid<MatrixRegularGrid>("matrix, Z-order", normalPointList, CellLayout::ZOrder);
+        benchmarkAutoCellSize("bounding box", normalPointList, CellSizeOptions(POINTS_PER_CELL));
+        benchmarkAutoCellSize("sampled", normalPointList, CellSizeOptions(POINTS_PER_CELL, DENSITY_SAMPLE_SIZE));
         std::cout << "------------------------------\n";
 
     }
     return 0;
-}
\ No newline at end of file
+}
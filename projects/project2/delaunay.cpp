@@ -1,13 +1,18 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
-#include <map>
-#include <tuple>
-#include <set>
+#include <array>
+#include <cmath>
+#include <limits>
 #include <random>
 #include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
 
 const int STD_DEV = 100;
+// larger random clouds are only timed, not written to files
+const int MAX_POINTS_TO_FILE = 1e4;
 
 // Return -1 if a < b, 0 if a = b and 1 if a > b.
 int cmp_double(double a, double b = 0, double eps = 1e-9) {
@@ -33,165 +38,1027 @@ struct Point {
     }
 };
 
-double abs(const Point& p) {
-    return sqrt(p * p);
+// Triangle given by the indices of its vertices in the input point list
+typedef std::array<int, 3> Triangle;
+
+// Exact arithmetic for the predicates below, following Shewchuk's "Adaptive
+// Precision Floating-Point Arithmetic and Fast Robust Geometric Predicates":
+// an expansion is a sum of doubles, by increasing magnitude, whose bits do
+// not overlap, so its sign is the sign of its last component.
+typedef std::vector<double> Expansion;
+
+// Half an ulp of 1, the relative rounding error of an operation.
+const double ROUNDOFF = std::numeric_limits<double>::epsilon() / 2;
+// Bounds on the rounding error of the floating-point determinants, relative
+// to the sum of the absolute values of their terms.
+const double ORIENTATION_ERROR_BOUND = (3 + 16 * ROUNDOFF) * ROUNDOFF;
+const double IN_CIRCLE_ERROR_BOUND = (10 + 96 * ROUNDOFF) * ROUNDOFF;
+
+// x + y = a + b exactly, with x the rounded sum.
+void twoSum(double a, double b, double& x, double& y) {
+    x = a + b;
+    double bVirtual = x - a;
+    double aVirtual = x - bVirtual;
+    y = (a - aVirtual) + (b - bVirtual);
 }
 
-double euclideanDistance(const Point& p, const Point& q) {
-    return abs(p - q);
+Expansion toExpansion(double a, double b) {
+    double x, y;
+    twoSum(a, b, x, y);
+    return y == 0 ? Expansion{x} : Expansion{y, x};
 }
 
-struct Circle {
-    Point p;
-    double r;
-    Circle() {}
-    Circle(Point p, double r) : p(p), r(r) {}
-};
+// e + b, dropping zero components.
+Expansion growExpansion(const Expansion& e, double b) {
+    Expansion h;
+    double q = b;
+    for(double component : e) {
+        double x, y;
+        twoSum(q, component, x, y);
+        if(y != 0) {
+            h.push_back(y);
+        }
+        q = x;
+    }
+    if(q != 0 || h.empty()) {
+        h.push_back(q);
+    }
+    return h;
+}
 
-// Check if point p is inside circle c
-bool inCircle(const Circle& c, const Point& p) {
-    return cmp_double(euclideanDistance(c.p, p), c.r) <= 0;
+Expansion operator+ (const Expansion& e, const Expansion& f) {
+    Expansion h = e;
+    for(double component : f) {
+        h = growExpansion(h, component);
+    }
+    return h;
 }
 
-Circle circumCenter(const Point& p, const Point& q, const Point& r) {
-    Point a = p - r, b = q - r, c = Point(a * (p + r)/2, b * (q + r)/2);
-    Point circleCenter = Point(c % Point(a.y, b.y), Point(a.x, b.x) % c) / (a % b);
-    double circleRadius = euclideanDistance(circleCenter, p);
-    return Circle(circleCenter, circleRadius);
+Expansion operator- (const Expansion& e) {
+    Expansion h = e;
+    for(double& component : h) {
+        component = -component;
+    }
+    return h;
 }
 
+// e * b, dropping zero components; products are split exactly with fma.
+Expansion scaleExpansion(const Expansion& e, double b) {
+    Expansion h;
+    double q = 0;
+    for(double component : e) {
+        double product = component * b;
+        double productError = std::fma(component, b, -product);
+        double sum, error;
+        twoSum(q, productError, sum, error);
+        if(error != 0) {
+            h.push_back(error);
+        }
+        twoSum(product, sum, q, error);
+        if(error != 0) {
+            h.push_back(error);
+        }
+    }
+    if(q != 0 || h.empty()) {
+        h.push_back(q);
+    }
+    return h;
+}
 
-struct Edge {
-    Point u, v;
-    bool toRemove;
-    Edge() {}
-    Edge(Point u, Point v) : u(u), v(v), toRemove(false) {}
-    bool operator== (const Edge& o) const {
-        return (u == o.u && v == o.v) || (v == o.u && u == o.v);
+Expansion operator* (const Expansion& e, const Expansion& f) {
+    Expansion h{0};
+    for(double component : f) {
+        h = h + scaleExpansion(e, component);
     }
-    bool operator< (const Edge& o) const {
-        return !(u == o.u) ? u < o.u : v < o.v;
+    return h;
+}
+
+// Orientation of the turn a -> b -> c: positive if counter-clockwise,
+// negative if clockwise and 0 if the points are collinear. The sign is
+// exact: the floating-point determinant is only trusted when it is larger
+// than its error bound, otherwise it is recomputed with expansions.
+double orientation(const Point& a, const Point& b, const Point& c) {
+    double left = (a.x - c.x) * (b.y - c.y);
+    double right = (a.y - c.y) * (b.x - c.x);
+    double det = left - right;
+    if(std::abs(det) > ORIENTATION_ERROR_BOUND * (std::abs(left) + std::abs(right))) {
+        return det;
     }
-};
+    Expansion acx = toExpansion(a.x, -c.x), acy = toExpansion(a.y, -c.y);
+    Expansion bcx = toExpansion(b.x, -c.x), bcy = toExpansion(b.y, -c.y);
+    return (acx * bcy + -(acy * bcx)).back();
+}
+
+// Sign of the in-circle determinant below once the lifted coordinate
+// x^2 + y^2 of every point is raised by an infinitesimal, larger for smaller
+// ids. The determinant grows by each infinitesimal times a coefficient that
+// is, up to sign, the orientation of the other three points, so the smallest
+// id with a nonzero coefficient decides. The four ids must be distinct.
+bool perturbedInCircumcircle(const Point& a, const Point& b, const Point& c, const Point& p,
+                             int aId, int bId, int cId, int pId) {
+    std::array<std::pair<int, int>, 4> ids{{{aId, 0}, {bId, 1}, {cId, 2}, {pId, 3}}};
+    std::sort(ids.begin(), ids.end());
+    for(auto& id : ids) {
+        double coefficient;
+        if(id.second == 0) {
+            coefficient = orientation(b, c, p);
+        } else if(id.second == 1) {
+            coefficient = -orientation(a, c, p);
+        } else if(id.second == 2) {
+            coefficient = orientation(a, b, p);
+        } else {
+            coefficient = -orientation(a, b, c);
+        }
+        if(coefficient != 0) {
+            return coefficient > 0;
+        }
+    }
+    return false;
+}
 
-struct Triangle {
-    Point a, b, c;
-    bool toRemove;
-    Triangle() {}
-    Triangle(Point a, Point b, Point c) : a(a), b(b), c(c), toRemove(false) {}
-    bool circumCircleContainsPoint(const Point& p) {
-        Circle circle = circumCenter(a, b, c);
-        return inCircle(circle, p);
+// Check if p lies inside the circumcircle of the counter-clockwise triangle
+// abc, with the same floating-point filter and exact fallback. A point
+// exactly on the circle is decided by perturbedInCircumcircle on the ids of
+// the points, so four cocircular points always get the same answer whatever
+// order they are tested in, and any two triangulations built with this
+// predicate are the same.
+bool inCircumcircle(const Point& a, const Point& b, const Point& c, const Point& p,
+                    int aId, int bId, int cId, int pId) {
+    double adx = a.x - p.x, ady = a.y - p.y;
+    double bdx = b.x - p.x, bdy = b.y - p.y;
+    double cdx = c.x - p.x, cdy = c.y - p.y;
+    double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+    double cdxady = cdx * ady, adxcdy = adx * cdy;
+    double adxbdy = adx * bdy, bdxady = bdx * ady;
+    double aLift = adx * adx + ady * ady;
+    double bLift = bdx * bdx + bdy * bdy;
+    double cLift = cdx * cdx + cdy * cdy;
+    double det = aLift * (bdxcdy - cdxbdy) + bLift * (cdxady - adxcdy) + cLift * (adxbdy - bdxady);
+    double permanent = (std::abs(bdxcdy) + std::abs(cdxbdy)) * aLift +
+                       (std::abs(cdxady) + std::abs(adxcdy)) * bLift +
+                       (std::abs(adxbdy) + std::abs(bdxady)) * cLift;
+    if(std::abs(det) > IN_CIRCLE_ERROR_BOUND * permanent) {
+        return det > 0;
+    }
+    Expansion ax = toExpansion(a.x, -p.x), ay = toExpansion(a.y, -p.y);
+    Expansion bx = toExpansion(b.x, -p.x), by = toExpansion(b.y, -p.y);
+    Expansion cx = toExpansion(c.x, -p.x), cy = toExpansion(c.y, -p.y);
+    Expansion exactDet = (ax * ax + ay * ay) * (bx * cy + -(by * cx)) +
+                         (bx * bx + by * by) * (cx * ay + -(cy * ax)) +
+                         (cx * cx + cy * cy) * (ax * by + -(ay * bx));
+    if(exactDet.back() != 0) {
+        return exactDet.back() > 0;
     }
-    bool isVertexEqualPoint(Point& p) {
-        return a == p || b == p || c == p;
+    return perturbedInCircumcircle(a, b, c, p, aId, bId, cId, pId);
+}
+
+// Position of cell (x, y) along the Hilbert curve that fills a grid of
+// 2^order x 2^order cells.
+uint64_t hilbertIndex(uint32_t x, uint32_t y, int order) {
+    uint32_t side = 1u << order;
+    uint64_t d = 0;
+    for(uint32_t s = side / 2; s > 0; s /= 2) {
+        uint32_t rx = (x & s) > 0;
+        uint32_t ry = (y & s) > 0;
+        d += (uint64_t) s * s * ((3 * rx) ^ ry);
+        // rotate the quadrant so the curve inside it has the standard orientation
+        if(ry == 0) {
+            if(rx == 1) {
+                x = side - 1 - x;
+                y = side - 1 - y;
+            }
+            std::swap(x, y);
+        }
     }
+    return d;
+}
+
+// Ids of the distinct points, in sorted order of the points. Each group of
+// repeated points is represented by its smallest id, that is its first
+// occurrence.
+std::vector<int> getDistinctPointIds(const std::vector<Point>& points) {
+    std::vector<std::pair<Point, int>> items(points.size());
+    for(size_t i = 0; i < points.size(); i++) {
+        items[i] = std::make_pair(points[i], i);
+    }
+    std::sort(items.begin(), items.end());
+    // points kept so far, and for each the first kept point with the same x
+    std::vector<std::pair<Point, int>> kept;
+    std::vector<int> runStart;
+    for(auto& item : items) {
+        const Point& p = item.first;
+        // a point equal to p is within the tolerance in x, so it is among the
+        // last ones kept; a run of equal x is sorted by y, so once a point of
+        // the run is below p the rest of the run can be skipped
+        int k = (int) kept.size() - 1;
+        while(k >= 0 && cmp_double(kept[k].first.x, p.x) == 0 && !(kept[k].first == p)) {
+            k = cmp_double(kept[k].first.y, p.y) < 0 ? runStart[k] - 1 : k - 1;
+        }
+        if(k >= 0 && kept[k].first == p) {
+            kept[k].second = std::min(kept[k].second, item.second);
+            continue;
+        }
+        runStart.push_back(!kept.empty() && kept.back().first.x == p.x ? runStart.back() : kept.size());
+        kept.push_back(item);
+    }
+    std::vector<int> ids(kept.size());
+    for(size_t i = 0; i < kept.size(); i++) {
+        ids[i] = kept[i].second;
+    }
+    return ids;
+}
+
+// Order in which Delaunay inserts the points: as given, along a Hilbert
+// curve over their bounding box, or in biased randomized insertion order
+// (BRIO) rounds, each of about twice the points of the previous one and
+// sorted along the Hilbert curve.
+enum class InsertionOrder { Input, Hilbert, BRIO };
+
+// Triangle of the mesh built by Delaunay: vertices are ids into the point
+// list, in counter-clockwise order, and adj[i] is the triangle across the
+// edge opposite v[i], that is the edge v[i+1] -> v[i+2]. A ghost triangle has
+// the vertex at infinity instead of one of its vertices; there is one
+// outside each convex hull edge, so every edge has a triangle on both sides.
+struct MeshTriangle {
+    int v[3];
+    int adj[3];
+    bool removed;
+};
+
+// Circumcircle of a mesh triangle, cached when the triangle is created, with
+// a bound on the distance from the computed center to the exact one. A point
+// is decided from the cache only when that bound and the rounding of the
+// squared distances cannot change the sign of the exact predicate; any other
+// point, and every point tested against a ghost triangle or a sliver, whose
+// error is infinite, goes through inCircumcircle.
+struct CachedCircle {
+    Point center;
+    double radius2, error;
 };
 
 class Delaunay {
     std::vector<Point> points;
+    bool cacheCircumcircles;
+    InsertionOrder insertionOrder;
+    // id of the vertex at infinity, one past the last point
+    int infinite;
+    std::vector<MeshTriangle> mesh;
+    // circumcircle of each triangle of the mesh, if cacheCircumcircles is set
+    std::vector<CachedCircle> circles;
+    // slots of removed triangles, reused by new ones
+    std::vector<int> freeTriangles;
+    // triangle where the next point location starts, unless a hint is closer
+    int lastTriangle;
+    // point location hints: a pyramid of grids over the bounding box of the
+    // points, level l having (1 << (hintLevels - 1 - l)) cells per side, each
+    // holding a triangle recently created around a point of the cell (-1 if none)
+    std::vector<std::vector<int>> hints;
+    int hintLevels;
+    double hintMinX, hintMinY, hintCellSize;
+
+    // edge u -> w of the cavity boundary, seen from inside the cavity, and
+    // the triangle across it with the index of that edge in it
+    struct CavityEdge {
+        int u, w, outer, outerEdge;
+    };
+    std::vector<int> cavity;
+    std::vector<CavityEdge> cavityBoundary;
+    // new triangle whose boundary edge starts at each vertex
+    std::vector<int> triangleFrom;
 
     public:
 
-        Delaunay(std::vector<Point>& pointList) {
+        Delaunay(std::vector<Point>& pointList, bool cacheCircumcircles = false,
+                 InsertionOrder insertionOrder = InsertionOrder::Input) {
             points = pointList;
+            this->cacheCircumcircles = cacheCircumcircles;
+            this->insertionOrder = insertionOrder;
         }
 
+        // Bowyer-Watson insertion over a triangle mesh with adjacency: each point
+        // is located by walking from a triangle created near it (or the last one
+        // created), and only the triangles whose circumcircle contains it are
+        // visited and replaced. The mesh starts from a first triangle of points
+        // and its ghost triangles, so no enclosing vertex can hide a thin hull
+        // triangle. Triangles are counter-clockwise and a repeated point is
+        // represented by its first occurrence.
         std::vector<Triangle> triangulate() {
-            // initialize result
             std::vector<Triangle> triangles;
+            int n = points.size();
+            if(n < 3) {
+                return triangles;
+            }
+            infinite = n;
+            std::vector<int> order = getInsertionOrder();
+            int numInserted = order.size();
+            // first triangle: the first point, the next one apart from it and
+            // the next one off the line through both and apart from both, as a
+            // copy of either can be off the line by less than the tolerance
+            const Point& p0 = points[order[0]];
+            int second = 1;
+            while(second < numInserted && points[order[second]] == p0) {
+                second++;
+            }
+            int third = second + 1;
+            while(third < numInserted && (orientation(p0, points[order[second]], points[order[third]]) == 0 ||
+                                          points[order[third]] == p0 || points[order[third]] == points[order[second]])) {
+                third++;
+            }
+            if(third >= numInserted) {
+                // all points on a line
+                return triangles;
+            }
 
-            // Determine enclosing triangle
-            Triangle enclosingTriangle = getEnclosingTriangle();
-            triangles.emplace_back(enclosingTriangle);
-
-            for(auto& point : points) {
-
-                std::set<Edge> edgesForNewTriangles;
-                
-                for(auto& triangle : triangles) {
-                    if(triangle.circumCircleContainsPoint(point)) {
-                        // mark triangle to remove later
-                        triangle.toRemove = true;
-
-                        // add edges to create new triangles
-                        Edge ab = Edge(triangle.a, triangle.b);
-                        Edge ac = Edge(triangle.a, triangle.c);
-                        Edge bc = Edge(triangle.b, triangle.c);
-                        insertOrEraseEdgeFromSet(ab, edgesForNewTriangles);
-                        insertOrEraseEdgeFromSet(ac, edgesForNewTriangles);
-                        insertOrEraseEdgeFromSet(bc, edgesForNewTriangles);
-                    }
-                }
-                // remove triangles which contains current point
-                triangles.erase(std::remove_if(triangles.begin(), triangles.end(), [](Triangle& t) {
-                    return t.toRemove;
-                }), triangles.end());
-
-                // add new triangles using edgesForNewTriangles
-                for(auto& edge : edgesForNewTriangles) {
-                    triangles.emplace_back(Triangle(edge.u, edge.v, point));
+            mesh.clear();
+            circles.clear();
+            freeTriangles.clear();
+            mesh.reserve(2 * n + 4);
+            if(cacheCircumcircles) {
+                circles.reserve(2 * n + 4);
+            }
+            int a = order[0], b = order[second], c = order[third];
+            if(orientation(points[a], points[b], points[c]) < 0) {
+                std::swap(b, c);
+            }
+            int first = newTriangle(a, b, c);
+            for(int k = 0; k < 3; k++) {
+                // ghost triangle across the edge opposite v[k]
+                int ghost = newTriangle(mesh[first].v[(k + 2) % 3], mesh[first].v[(k + 1) % 3], infinite);
+                mesh[first].adj[k] = ghost;
+                mesh[ghost].adj[2] = first;
+            }
+            for(int k = 0; k < 3; k++) {
+                int ghost = mesh[first].adj[k];
+                mesh[ghost].adj[0] = mesh[first].adj[(k + 2) % 3];
+                mesh[ghost].adj[1] = mesh[first].adj[(k + 1) % 3];
+            }
+            lastTriangle = first;
+            triangleFrom.assign(n + 1, -1);
+            initHints();
+
+            // vertex ids stay the positions in points, whatever the order
+            for(int i = 1; i < numInserted; i++) {
+                if(i != second && i != third) {
+                    insertVertex(order[i]);
                 }
             }
-            // remove triangles which have vertices equal to a vertex from enclosing triangle
-            triangles.erase(std::remove_if(triangles.begin(), triangles.end(), [&](Triangle& t) {
-                return t.isVertexEqualPoint(enclosingTriangle.a) || t.isVertexEqualPoint(enclosingTriangle.b) ||
-                       t.isVertexEqualPoint(enclosingTriangle.c);
-            }), triangles.end());
 
+            // keep the triangles that do not use the vertex at infinity
+            for(auto& t : mesh) {
+                if(!t.removed && t.v[0] != infinite && t.v[1] != infinite && t.v[2] != infinite) {
+                    triangles.push_back(Triangle{t.v[0], t.v[1], t.v[2]});
+                }
+            }
             return triangles;
         }
 
     private:
-        Triangle getEnclosingTriangle() {
-            double minX = points[0].x;
-            double maxX = minX;
-            double minY = points[0].y;
-            double maxY = minY;
+        // Ids of the points in the order they are inserted. Out of input
+        // order only the first occurrence of a repeated point is inserted, so
+        // no later copy can come first and take its place.
+        std::vector<int> getInsertionOrder() {
+            if(insertionOrder == InsertionOrder::Input) {
+                std::vector<int> order(points.size());
+                for(size_t i = 0; i < order.size(); i++) {
+                    order[i] = i;
+                }
+                return order;
+            }
+            std::vector<int> order = getDistinctPointIds(points);
+            int n = order.size();
+
+            const int HILBERT_ORDER = 16;
+            double minX = points[0].x, maxX = minX, minY = points[0].y, maxY = minY;
+            for(auto& p : points) {
+                minX = std::min(minX, p.x);
+                maxX = std::max(maxX, p.x);
+                minY = std::min(minY, p.y);
+                maxY = std::max(maxY, p.y);
+            }
+            double maxCell = (1 << HILBERT_ORDER) - 1;
+            double scale = maxCell / std::max(std::max(maxX - minX, maxY - minY), 1e-300);
+            // sort key of each point: its round, then its Hilbert index
+            std::vector<std::pair<uint64_t, int>> keys(n);
+            std::default_random_engine generator;
+            std::bernoulli_distribution coin(0.5);
+            for(int i = 0; i < n; i++) {
+                const Point& p = points[order[i]];
+                uint32_t x = std::min((p.x - minX) * scale, maxCell);
+                uint32_t y = std::min((p.y - minY) * scale, maxCell);
+                uint64_t round = 0;
+                if(insertionOrder == InsertionOrder::BRIO) {
+                    // a point goes to the last round with probability 1/2, to
+                    // the one before with probability 1/4, and so on
+                    int roundsBeforeLast = 0;
+                    while(roundsBeforeLast < 31 && coin(generator)) {
+                        roundsBeforeLast++;
+                    }
+                    round = 31 - roundsBeforeLast;
+                }
+                keys[i] = std::make_pair(round << (2 * HILBERT_ORDER) | hilbertIndex(x, y, HILBERT_ORDER), order[i]);
+            }
+            std::sort(keys.begin(), keys.end());
+            for(int i = 0; i < n; i++) {
+                order[i] = keys[i].second;
+            }
+            return order;
+        }
 
+        // Finest level with about two points per cell once every point is in.
+        void initHints() {
+            double minX = points[0].x, maxX = minX, minY = points[0].y, maxY = minY;
             for(auto& p : points) {
                 minX = std::min(minX, p.x);
                 maxX = std::max(maxX, p.x);
                 minY = std::min(minY, p.y);
                 maxY = std::max(maxY, p.y);
             }
+            hintLevels = 1;
+            while((size_t) 1 << (2 * hintLevels) <= points.size() / 2) {
+                hintLevels++;
+            }
+            int side = 1 << (hintLevels - 1);
+            hintMinX = minX;
+            hintMinY = minY;
+            hintCellSize = std::max(std::max(maxX - minX, maxY - minY) / side, 1e-300);
+            hints.assign(hintLevels, std::vector<int>());
+            for(int l = 0; l < hintLevels; l++) {
+                hints[l].assign((size_t) (side >> l) * (side >> l), -1);
+            }
+        }
 
-            double halfSide = std::max(maxX - minX, maxY - minY);
-            double midX = (maxX + minX) / 2.0;
-            double midY = (maxY + minY) / 2.0;
-            Point a = Point(midX - 20.0 * halfSide, midY - 20.0 * halfSide);
-            Point b = Point(midX, midY + 20.0 * halfSide);
-            Point c = Point(midX + 20.0 * halfSide, midY);
-            return Triangle(a, b, c);
+        // Cell of p in the finest hint level.
+        std::pair<int, int> getHintCell(const Point& p) {
+            int maxCell = (1 << (hintLevels - 1)) - 1;
+            int x = std::min(std::max((int) ((p.x - hintMinX) / hintCellSize), 0), maxCell);
+            int y = std::min(std::max((int) ((p.y - hintMinY) / hintCellSize), 0), maxCell);
+            return std::make_pair(x, y);
         }
 
-        void insertOrEraseEdgeFromSet(const Edge& e, std::set<Edge>& edgesSet) {
-            // if edge is already in set remove it, otherwise add it
-            if(edgesSet.count(e)) {
-                edgesSet.erase(e);
+        void setHint(const Point& p, int t) {
+            auto cell = getHintCell(p);
+            for(int l = 0; l < hintLevels; l++) {
+                int side = 1 << (hintLevels - 1 - l);
+                hints[l][(size_t) (cell.first >> l) * side + (cell.second >> l)] = t;
+            }
+        }
+
+        // Live triangle recorded in the finest level that has one near p.
+        int getHint(const Point& p) {
+            auto cell = getHintCell(p);
+            for(int l = 0; l < hintLevels; l++) {
+                int side = 1 << (hintLevels - 1 - l);
+                int t = hints[l][(size_t) (cell.first >> l) * side + (cell.second >> l)];
+                if(t != -1 && !mesh[t].removed) {
+                    return t;
+                }
+            }
+            return lastTriangle;
+        }
+
+        // Position of the vertex at infinity in triangle t, -1 if it is not a ghost.
+        int getInfiniteCorner(int t) {
+            for(int k = 0; k < 3; k++) {
+                if(mesh[t].v[k] == infinite) {
+                    return k;
+                }
+            }
+            return -1;
+        }
+
+        // Triangle containing vertex p, found by walking towards it from a
+        // triangle near it: step across any edge that has p on its outer side.
+        // A point outside the convex hull ends in the ghost triangle of a hull
+        // edge it sees.
+        int locate(const Point& p) {
+            int t = getHint(p);
+            // rotate the first edge tried so the walk cannot cycle
+            int start = 0;
+            while(true) {
+                const MeshTriangle& triangle = mesh[t];
+                int next = -1;
+                int corner = getInfiniteCorner(t);
+                if(corner != -1) {
+                    const Point& u = points[triangle.v[(corner + 1) % 3]];
+                    const Point& w = points[triangle.v[(corner + 2) % 3]];
+                    if(orientation(u, w, p) > 0) {
+                        return t;
+                    }
+                    next = triangle.adj[corner];
+                }
+                for(int k = 0; k < 3 && next == -1; k++) {
+                    int i = (start + k) % 3;
+                    const Point& u = points[triangle.v[(i + 1) % 3]];
+                    const Point& w = points[triangle.v[(i + 2) % 3]];
+                    if(orientation(u, w, p) < 0) {
+                        next = triangle.adj[i];
+                    }
+                }
+                if(next == -1) {
+                    return t;
+                }
+                t = next;
+                start = (start + 1) % 3;
+            }
+        }
+
+        void insertVertex(int id) {
+            const Point& p = points[id];
+            int t = locate(p);
+            for(int i = 0; i < 3; i++) {
+                if(mesh[t].v[i] != infinite && points[mesh[t].v[i]] == p) {
+                    // duplicate point, already in the mesh
+                    return;
+                }
+            }
+
+            // flood-fill the cavity: triangles whose circumcircle contains p,
+            // starting from the one containing it
+            cavity.clear();
+            cavityBoundary.clear();
+            mesh[t].removed = true;
+            cavity.push_back(t);
+            for(int k = 0; k < cavity.size(); k++) {
+                int bad = cavity[k];
+                for(int i = 0; i < 3; i++) {
+                    int neighbour = mesh[bad].adj[i];
+                    if(mesh[neighbour].removed) {
+                        continue;
+                    }
+                    if(inCircumcircle(neighbour, id)) {
+                        mesh[neighbour].removed = true;
+                        cavity.push_back(neighbour);
+                        continue;
+                    }
+                    CavityEdge edge{mesh[bad].v[(i + 1) % 3], mesh[bad].v[(i + 2) % 3], neighbour, -1};
+                    for(int j = 0; j < 3; j++) {
+                        if(mesh[neighbour].adj[j] == bad) {
+                            edge.outerEdge = j;
+                        }
+                    }
+                    cavityBoundary.push_back(edge);
+                }
+            }
+            for(int bad : cavity) {
+                freeTriangles.push_back(bad);
+            }
+
+            // fan the boundary of the cavity around p
+            for(auto& edge : cavityBoundary) {
+                int created = newTriangle(edge.u, edge.w, id);
+                mesh[created].adj[2] = edge.outer;
+                mesh[edge.outer].adj[edge.outerEdge] = created;
+                triangleFrom[edge.u] = created;
+            }
+            for(auto& edge : cavityBoundary) {
+                int created = triangleFrom[edge.u];
+                // the edge w -> p is shared with the triangle built on the boundary edge leaving w
+                int next = triangleFrom[edge.w];
+                mesh[created].adj[0] = next;
+                mesh[next].adj[1] = created;
+            }
+            lastTriangle = triangleFrom[cavityBoundary[0].u];
+            setHint(p, lastTriangle);
+        }
+
+        int newTriangle(int a, int b, int c) {
+            MeshTriangle triangle{{a, b, c}, {-1, -1, -1}, false};
+            int t;
+            if(!freeTriangles.empty()) {
+                t = freeTriangles.back();
+                freeTriangles.pop_back();
+                mesh[t] = triangle;
             } else {
-                edgesSet.emplace(e);
+                t = mesh.size();
+                mesh.push_back(triangle);
+                if(cacheCircumcircles) {
+                    circles.emplace_back();
+                }
+            }
+            if(cacheCircumcircles) {
+                if(a == infinite || b == infinite || c == infinite) {
+                    circles[t].error = std::numeric_limits<double>::infinity();
+                } else {
+                    circles[t] = getCircumcircle(points[a], points[b], points[c]);
+                }
+            }
+            return t;
+        }
+
+        // Center and squared radius of the circle through p, q and r, with a
+        // first-order bound on the rounding error of the center, summed over
+        // both coordinates. The differences from r, the products and the sums
+        // each add at most EPS relative error, and the divisor det is known to
+        // a relative error rho; a sliver with rho of 1/4 or more is left to
+        // the exact predicate.
+        CachedCircle getCircumcircle(const Point& p, const Point& q, const Point& r) {
+            const double EPS = std::numeric_limits<double>::epsilon() / 2;
+            Point a = p - r, b = q - r;
+            double det = a % b;
+            double a2 = a * a, b2 = b * b;
+            CachedCircle circle;
+            Point offset = Point(b.y * a2 - a.y * b2, a.x * b2 - b.x * a2) / (2 * det);
+            circle.center = r + offset;
+            circle.radius2 = offset * offset;
+            double rho = 8 * EPS * (std::abs(a.x * b.y) + std::abs(a.y * b.x)) / std::abs(det);
+            if(!(rho < 0.25) || !std::isfinite(circle.radius2)) {
+                circle.error = std::numeric_limits<double>::infinity();
+                return circle;
+            }
+            double errorX = 8 * EPS * (std::abs(b.y) * a2 + std::abs(a.y) * b2) / (2 * std::abs(det)) +
+                            std::abs(offset.x) * (rho + EPS);
+            double errorY = 8 * EPS * (std::abs(a.x) * b2 + std::abs(b.x) * a2) / (2 * std::abs(det)) +
+                            std::abs(offset.y) * (rho + EPS);
+            // 1 / (1 - rho) < 2 covers the error of det in the quotient, and
+            // the last terms the rounding of r + offset
+            circle.error = 2 * (errorX + errorY) +
+                           2 * EPS * (std::abs(r.x) + std::abs(offset.x) + std::abs(r.y) + std::abs(offset.y));
+            return circle;
+        }
+
+        bool inCircumcircle(int t, int id) {
+            const Point& p = points[id];
+            if(cacheCircumcircles) {
+                // with the center off by at most error, the exact squared
+                // distances differ from d2 and radius2 by rounding, within
+                // 8 EPS of their sum, and by at most 2 error (d + r) + error^2,
+                // where (d + r)^2 <= 2 (d2 + radius2)
+                const double EPS = std::numeric_limits<double>::epsilon() / 2;
+                const CachedCircle& circle = circles[t];
+                Point d = p - circle.center;
+                double d2 = d * d;
+                double diff = d2 - circle.radius2;
+                double margin = std::abs(diff) - 8 * EPS * (d2 + circle.radius2) - circle.error * circle.error;
+                if(margin > 0 && margin * margin > 9 * circle.error * circle.error * (d2 + circle.radius2)) {
+                    return diff < 0;
+                }
+            }
+            const MeshTriangle& triangle = mesh[t];
+            int corner = getInfiniteCorner(t);
+            if(corner != -1) {
+                // the circle through a hull edge and a point at infinity is the
+                // half-plane beyond the edge, plus the open edge itself
+                const Point& u = points[triangle.v[(corner + 1) % 3]];
+                const Point& w = points[triangle.v[(corner + 2) % 3]];
+                double turn = orientation(u, w, p);
+                return turn > 0 || (turn == 0 && ((u < p && p < w) || (w < p && p < u)));
             }
+            return ::inCircumcircle(points[triangle.v[0]], points[triangle.v[1]], points[triangle.v[2]], p,
+                                    triangle.v[0], triangle.v[1], triangle.v[2], id);
         }
 
 };
 
-// Auxiliary methods
-std::vector<std::tuple<int, int, int>> getTriangulationIndexes(const std::vector<Point>& pointList, const std::vector<Triangle>& triangles) {
-    std::vector<std::tuple<int, int, int>> result;
-    std::map<Point, int> pointToIndex;
-    for(int i = 0; i < pointList.size(); i++) {
-        pointToIndex.emplace(std::make_pair(pointList[i], i));
-    }
-    for(auto& t : triangles) {
-        int indexA = pointToIndex[t.a];
-        int indexB = pointToIndex[t.b];
-        int indexC = pointToIndex[t.c];
-        result.emplace_back(std::make_tuple(indexA, indexB, indexC));
+// Directed edge of the quad-edge structure used by ParallelDelaunay. The four
+// edges of a QuadEdge are an undirected edge in both directions (0 and 2)
+// and its dual edge in both directions (1 and 3); next is the next edge
+// counter-clockwise around the origin.
+struct QuadEdgeEdge {
+    int num;
+    int origin;
+    QuadEdgeEdge* next;
+
+    QuadEdgeEdge* rot() { return num < 3 ? this + 1 : this - 3; }
+    QuadEdgeEdge* invRot() { return num > 0 ? this - 1 : this + 3; }
+    QuadEdgeEdge* sym() { return num < 2 ? this + 2 : this - 2; }
+    QuadEdgeEdge* oNext() { return next; }
+    QuadEdgeEdge* oPrev() { return rot()->next->rot(); }
+    QuadEdgeEdge* lNext() { return invRot()->next->rot(); }
+    QuadEdgeEdge* rPrev() { return sym()->next; }
+    int dest() { return sym()->origin; }
+};
+
+struct QuadEdge {
+    QuadEdgeEdge e[4];
+    bool deleted;
+};
+
+// Quad-edges allocated by one thread, in chunks so their addresses never move.
+struct QuadEdgePool {
+    static const int CHUNK_SIZE = 1 << 14;
+    std::vector<std::unique_ptr<QuadEdge[]>> chunks;
+    int used = CHUNK_SIZE;
+
+    QuadEdge* allocate() {
+        if(used == CHUNK_SIZE) {
+            chunks.emplace_back(new QuadEdge[CHUNK_SIZE]);
+            used = 0;
+        }
+        return &chunks.back()[used++];
     }
-    return result;
-}
+};
+
+// Delaunay triangulation by Guibas and Stolfi's divide and conquer: the
+// points are split in two halves, each half is triangulated and the two are
+// merged by zipping the edges between them from the bottom up. As in Dwyer's
+// variant the cuts alternate between x and y, which keeps the halves round
+// and the merges short; a cut along y is merged in a frame turned by 90
+// degrees, where the predicates give the same answers. Both halves of a
+// split are independent, so the second one is built on another thread while
+// the threads last. Both builders break cocircular ties with the same
+// symbolic perturbation, so the triangulation is the one of Delaunay even on
+// grids and other degenerate clouds.
+class ParallelDelaunay {
+    std::vector<Point> points;
+    int numThreads;
+    // ids of the distinct points, in the order of the cuts, and the points in
+    // that order; edges refer to positions in this order
+    std::vector<int> sorted;
+    std::vector<Point> sortedPoints;
+    // one pool per thread of the recursion
+    std::vector<QuadEdgePool> pools;
+
+    // subproblems smaller than this are not split over threads
+    static const int PARALLEL_CUTOFF = 1 << 12;
+
+    public:
+
+        ParallelDelaunay(std::vector<Point>& pointList, int numThreads = 1) {
+            points = pointList;
+            this->numThreads = std::max(numThreads, 1);
+        }
+
+        // Same triangles as Delaunay::triangulate(): counter-clockwise and
+        // with a repeated point represented by its first occurrence.
+        std::vector<Triangle> triangulate() {
+            std::vector<Triangle> triangles;
+            sorted = getDistinctPointIds(points);
+            if(sorted.size() < 3) {
+                return triangles;
+            }
+            int n = sorted.size();
+            std::vector<std::pair<Point, int>> items(n);
+            for(int i = 0; i < n; i++) {
+                items[i] = std::make_pair(points[sorted[i]], sorted[i]);
+            }
+            sortedPoints.resize(n);
+            orderPoints(items, 0, n, numThreads, 0);
+            for(int i = 0; i < n; i++) {
+                sortedPoints[i] = items[i].first;
+                sorted[i] = items[i].second;
+            }
+
+            pools.clear();
+            pools.resize(numThreads);
+            build(0, n, numThreads, 0, 0);
+
+            // each thread reads the triangles off its own pool
+            std::vector<std::vector<Triangle>> poolTriangles(numThreads);
+            std::vector<std::thread> threads;
+            for(int i = 1; i < numThreads; i++) {
+                threads.emplace_back([this, &poolTriangles, i]() {
+                    collectTriangles(pools[i], poolTriangles[i]);
+                });
+            }
+            collectTriangles(pools[0], poolTriangles[0]);
+            for(auto& thread : threads) {
+                thread.join();
+            }
+            for(auto& list : poolTriangles) {
+                triangles.insert(triangles.end(), list.begin(), list.end());
+            }
+            return triangles;
+        }
+
+    private:
+        // Order of the points along the cut axis: x then y for axis 0, and y
+        // then -x for axis 1, that is x then y in the frame turned by 90 degrees.
+        static bool precedes(const Point& a, const Point& b, int axis) {
+            if(axis == 0) {
+                return a < b;
+            }
+            return a.y != b.y ? a.y < b.y : a.x > b.x;
+        }
+
+        // Arrange items[first, last) the way build splits them: the first half
+        // precedes the second along axis, and each half is arranged along the
+        // other axis; the two or three points of a leaf are sorted.
+        void orderPoints(std::vector<std::pair<Point, int>>& items, int first, int last, int threads, int axis) {
+            auto less = [axis](const std::pair<Point, int>& a, const std::pair<Point, int>& b) {
+                return precedes(a.first, b.first, axis);
+            };
+            int n = last - first;
+            if(n <= 3) {
+                std::sort(items.begin() + first, items.begin() + last, less);
+                return;
+            }
+            int middle = first + n / 2;
+            std::nth_element(items.begin() + first, items.begin() + middle, items.begin() + last, less);
+            if(threads > 1 && n >= PARALLEL_CUTOFF) {
+                std::thread secondThread([&]() {
+                    orderPoints(items, middle, last, threads / 2, 1 - axis);
+                });
+                orderPoints(items, first, middle, threads - threads / 2, 1 - axis);
+                secondThread.join();
+            } else {
+                orderPoints(items, first, middle, 1, 1 - axis);
+                orderPoints(items, middle, last, 1, 1 - axis);
+            }
+        }
+
+        // Walk the convex hull from its clockwise edge cw and return the
+        // counter-clockwise hull edge out of its first point along axis and
+        // the clockwise one out of its last point.
+        std::pair<QuadEdgeEdge*, QuadEdgeEdge*> getExtremeHullEdges(QuadEdgeEdge* cw, int axis) {
+            QuadEdgeEdge* lowest = nullptr;
+            QuadEdgeEdge* highest = nullptr;
+            QuadEdgeEdge* e = cw;
+            do {
+                // e enters its destination and e->lNext() leaves it
+                const Point& p = sortedPoints[e->dest()];
+                if(lowest == nullptr || precedes(p, sortedPoints[lowest->origin], axis)) {
+                    lowest = e->sym();
+                }
+                if(highest == nullptr || precedes(sortedPoints[highest->origin], p, axis)) {
+                    highest = e->lNext();
+                }
+                e = e->lNext();
+            } while(e != cw);
+            return std::make_pair(lowest, highest);
+        }
+
+        // Every bounded face is a counter-clockwise triangle; the outer face is
+        // the only clockwise one. Each triangle is reported once, from its edge
+        // leaving the vertex with the smallest position.
+        void collectTriangles(QuadEdgePool& pool, std::vector<Triangle>& triangles) {
+            for(auto& chunk : pool.chunks) {
+                int size = &chunk == &pool.chunks.back() ? pool.used : QuadEdgePool::CHUNK_SIZE;
+                for(int i = 0; i < size; i++) {
+                    if(chunk[i].deleted) {
+                        continue;
+                    }
+                    for(int k = 0; k < 4; k += 2) {
+                        QuadEdgeEdge* e = &chunk[i].e[k];
+                        QuadEdgeEdge* f = e->lNext();
+                        int a = e->origin, b = f->origin, c = f->dest();
+                        if(a < b && a < c && f->lNext()->lNext() == e &&
+                           orientation(sortedPoints[a], sortedPoints[b], sortedPoints[c]) > 0) {
+                            triangles.push_back(Triangle{sorted[a], sorted[b], sorted[c]});
+                        }
+                    }
+                }
+            }
+        }
+
+        QuadEdgeEdge* makeEdge(int origin, int dest, QuadEdgePool& pool) {
+            QuadEdge* q = pool.allocate();
+            q->deleted = false;
+            for(int i = 0; i < 4; i++) {
+                q->e[i].num = i;
+            }
+            q->e[0].next = &q->e[0];
+            q->e[1].next = &q->e[3];
+            q->e[2].next = &q->e[2];
+            q->e[3].next = &q->e[1];
+            q->e[0].origin = origin;
+            q->e[2].origin = dest;
+            return &q->e[0];
+        }
+
+        static void splice(QuadEdgeEdge* a, QuadEdgeEdge* b) {
+            QuadEdgeEdge* alpha = a->oNext()->rot();
+            QuadEdgeEdge* beta = b->oNext()->rot();
+            std::swap(a->next, b->next);
+            std::swap(alpha->next, beta->next);
+        }
+
+        // New edge from the destination of a to the origin of b, on their left face.
+        QuadEdgeEdge* connect(QuadEdgeEdge* a, QuadEdgeEdge* b, QuadEdgePool& pool) {
+            QuadEdgeEdge* e = makeEdge(a->dest(), b->origin, pool);
+            splice(e, a->lNext());
+            splice(e->sym(), b);
+            return e;
+        }
+
+        static void deleteEdge(QuadEdgeEdge* e) {
+            splice(e, e->oPrev());
+            splice(e->sym(), e->sym()->oPrev());
+            ((QuadEdge*) (e - e->num))->deleted = true;
+        }
+
+        bool leftOf(int p, QuadEdgeEdge* e) {
+            return orientation(sortedPoints[p], sortedPoints[e->origin], sortedPoints[e->dest()]) > 0;
+        }
+
+        bool rightOf(int p, QuadEdgeEdge* e) {
+            return orientation(sortedPoints[p], sortedPoints[e->dest()], sortedPoints[e->origin]) > 0;
+        }
+
+        // In-circle test on positions, with ties broken on the ids of the
+        // points as in Delaunay.
+        bool inCircle(int a, int b, int c, int p) {
+            return inCircumcircle(sortedPoints[a], sortedPoints[b], sortedPoints[c], sortedPoints[p],
+                                  sorted[a], sorted[b], sorted[c], sorted[p]);
+        }
+
+        // Triangulate sortedPoints[first, last), arranged by orderPoints, with
+        // the pools from poolId to poolId + threads - 1. Returns the
+        // counter-clockwise convex hull edge out of the first point along axis
+        // and the clockwise one out of the last point.
+        std::pair<QuadEdgeEdge*, QuadEdgeEdge*> build(int first, int last, int threads, int poolId, int axis) {
+            QuadEdgePool& pool = pools[poolId];
+            int n = last - first;
+            if(n == 2) {
+                QuadEdgeEdge* a = makeEdge(first, first + 1, pool);
+                return std::make_pair(a, a->sym());
+            }
+            if(n == 3) {
+                int s0 = first, s1 = first + 1, s2 = first + 2;
+                QuadEdgeEdge* a = makeEdge(s0, s1, pool);
+                QuadEdgeEdge* b = makeEdge(s1, s2, pool);
+                splice(a->sym(), b);
+                double turn = orientation(sortedPoints[s0], sortedPoints[s1], sortedPoints[s2]);
+                if(turn > 0) {
+                    connect(b, a, pool);
+                    return std::make_pair(a, b->sym());
+                }
+                if(turn < 0) {
+                    QuadEdgeEdge* c = connect(b, a, pool);
+                    return std::make_pair(c->sym(), c);
+                }
+                return std::make_pair(a, b->sym());
+            }
+
+            int middle = first + n / 2;
+            std::pair<QuadEdgeEdge*, QuadEdgeEdge*> left, right;
+            if(threads > 1 && n >= PARALLEL_CUTOFF) {
+                int leftThreads = threads - threads / 2;
+                std::thread rightThread([&]() {
+                    right = build(middle, last, threads / 2, poolId + leftThreads, 1 - axis);
+                });
+                left = build(first, middle, leftThreads, poolId, 1 - axis);
+                rightThread.join();
+            } else {
+                left = build(first, middle, 1, poolId, 1 - axis);
+                right = build(middle, last, 1, poolId, 1 - axis);
+            }
+            // the halves know their extreme points along the other axis
+            left = getExtremeHullEdges(left.second, axis);
+            right = getExtremeHullEdges(right.second, axis);
+            QuadEdgeEdge* ldo = left.first;
+            QuadEdgeEdge* ldi = left.second;
+            QuadEdgeEdge* rdi = right.first;
+            QuadEdgeEdge* rdo = right.second;
+
+            // lower common tangent of the two hulls
+            while(true) {
+                if(leftOf(rdi->origin, ldi)) {
+                    ldi = ldi->lNext();
+                } else if(rightOf(ldi->origin, rdi)) {
+                    rdi = rdi->rPrev();
+                } else {
+                    break;
+                }
+            }
+            QuadEdgeEdge* base = connect(rdi->sym(), ldi, pool);
+            if(ldi->origin == ldo->origin) {
+                ldo = base->sym();
+            }
+            if(rdi->origin == rdo->origin) {
+                rdo = base;
+            }
 
+            // zip the halves: each step adds the cross edge whose triangle with
+            // base has an empty circumcircle, deleting the edges it crosses. The
+            // next candidate may end at a vertex of base, which the exact
+            // predicate would only find to be on the circle after a slow fallback
+            while(true) {
+                QuadEdgeEdge* leftCandidate = base->sym()->oNext();
+                bool leftValid = rightOf(leftCandidate->dest(), base);
+                if(leftValid) {
+                    while(leftCandidate->oNext()->dest() != base->origin &&
+                          inCircle(base->dest(), base->origin, leftCandidate->dest(), leftCandidate->oNext()->dest())) {
+                        QuadEdgeEdge* next = leftCandidate->oNext();
+                        deleteEdge(leftCandidate);
+                        leftCandidate = next;
+                    }
+                }
+                QuadEdgeEdge* rightCandidate = base->oPrev();
+                bool rightValid = rightOf(rightCandidate->dest(), base);
+                if(rightValid) {
+                    while(rightCandidate->oPrev()->dest() != base->dest() &&
+                          inCircle(base->dest(), base->origin, rightCandidate->dest(), rightCandidate->oPrev()->dest())) {
+                        QuadEdgeEdge* next = rightCandidate->oPrev();
+                        deleteEdge(rightCandidate);
+                        rightCandidate = next;
+                    }
+                }
+                if(!leftValid && !rightValid) {
+                    break;
+                }
+                if(!leftValid || (rightValid && inCircle(leftCandidate->dest(), leftCandidate->origin,
+                                                         rightCandidate->origin, rightCandidate->dest()))) {
+                    base = connect(rightCandidate, base->sym(), pool);
+                } else {
+                    base = connect(base->sym(), leftCandidate->sym(), pool);
+                }
+            }
+            return std::make_pair(ldo, rdo);
+        }
+
+};
+
+// Auxiliary methods
 std::vector<Point> generateRandomPointList(int n, int stdDev) {
     std::vector<Point> result(n);
     std::default_random_engine generator;
@@ -203,6 +1070,38 @@ std::vector<Point> generateRandomPointList(int n, int stdDev) {
     return result;
 }
 
+// side x side points on a square grid of spacing 0.1, as in a survey grid:
+// every cell has four cocircular corners
+std::vector<Point> generateGridPointList(int side) {
+    std::vector<Point> result;
+    for(int i = 0; i < side; i++) {
+        for(int j = 0; j < side; j++) {
+            result.emplace_back(Point(i * 0.1, j * 0.1));
+        }
+    }
+    return result;
+}
+
+// Run the triangulation and print its execution time.
+template <typename Triangulation>
+std::vector<Triangle> timeTriangulation(Triangulation& delaunay, const std::string& label) {
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    std::vector<Triangle> triangleList = delaunay.triangulate();
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    std::cout << label << " execution time = " << std::chrono::duration_cast<std::chrono::milliseconds> (end - begin).count() << "[ms]" << '\n';
+    return triangleList;
+}
+
+// Triangles rotated to start at their smallest index, in sorted order, so
+// that triangulations built in different orders can be compared.
+std::vector<Triangle> getCanonicalTriangulation(std::vector<Triangle> triangles) {
+    for(auto& t : triangles) {
+        std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
 void createPointCloudFile(int n, std::vector<Point> pointList) {
     std::ofstream outFile;
     outFile.open("pointCloud" + std::to_string(n) + ".txt");
@@ -212,11 +1111,11 @@ void createPointCloudFile(int n, std::vector<Point> pointList) {
     outFile.close();
 }
 
-void createTriangulationFile(const std::string& name, const std::vector<std::tuple<int, int, int>>& trianglesIndexes) {
+void createTriangulationFile(const std::string& name, const std::vector<Triangle>& triangles) {
     std::ofstream outFile;
     outFile.open(name);
-    for(auto& p : trianglesIndexes) {
-        outFile << std::get<0>(p) << " " << std::get<1>(p) << " " << std::get<2>(p) << '\n';
+    for(auto& t : triangles) {
+        outFile << t[0] << " " << t[1] << " " << t[2] << '\n';
     }
     outFile.close();
 }
@@ -244,38 +1143,145 @@ int main() {
 
         Delaunay delaunay = Delaunay(pointList);
         std::vector<Triangle> triangleList = delaunay.triangulate();
-        std::vector<std::tuple<int, int, int>> trianglesIndexes = getTriangulationIndexes(pointList, triangleList);
         std::string name = "delaunay" + std::to_string(fileNum) + ".txt";
         std::cout << "Delaunay triangulation for " << file << ":" << '\n';
-        for(auto& p : trianglesIndexes) {
-            std::cout << std::get<0>(p) << " " << std::get<1>(p) << " " << std::get<2>(p) << '\n';
+        for(auto& t : triangleList) {
+            std::cout << t[0] << " " << t[1] << " " << t[2] << '\n';
         }
         std::cout << '\n';
         
-        createTriangulationFile(name, trianglesIndexes);
+        createTriangulationFile(name, triangleList);
         fileNum++;
+
+        ParallelDelaunay parallelDelaunay = ParallelDelaunay(pointList);
+        if(getCanonicalTriangulation(parallelDelaunay.triangulate()) != getCanonicalTriangulation(triangleList)) {
+            std::cout << "ERROR: the parallel triangulation of " << file << " differs\n\n";
+        }
     }
 
     std::cout << "Testing with different number of points, randomly generated" << '\n';
-    std::chrono::steady_clock::time_point begin;
-    std::chrono::steady_clock::time_point end;
-    std::vector<double> randomPointCloudSize{30, 70, 1e2, 3*1e2, 7*1e2, 1e3, 3*1e3, 7*1e3, 1e4};
+    std::vector<double> randomPointCloudSize{30, 70, 1e2, 3*1e2, 7*1e2, 1e3, 3*1e3, 7*1e3, 1e4, 1e5, 1e6, 5*1e6};
     for(int i : randomPointCloudSize) {
         std::cout << "n = " << i << '\n';
         std::vector<Point> pointList = generateRandomPointList(i, STD_DEV);
 
         Delaunay delaunay = Delaunay(pointList);
-        begin = std::chrono::steady_clock::now();
-        std::vector<Triangle> triangleList = delaunay.triangulate();
-        end = std::chrono::steady_clock::now();
-        std::cout << "Delaunay triangulation execution time = " << std::chrono::duration_cast<std::chrono::milliseconds> (end - begin).count() << "[ms]" << '\n';
+        std::vector<Triangle> triangleList = timeTriangulation(delaunay, "Delaunay triangulation");
+        Delaunay cachedDelaunay = Delaunay(pointList, true);
+        std::vector<Triangle> cachedTriangleList = timeTriangulation(cachedDelaunay, "Delaunay triangulation with cached circumcircles");
 
-        createPointCloudFile(i, pointList);
+        Delaunay hilbertDelaunay = Delaunay(pointList, false, InsertionOrder::Hilbert);
+        std::vector<Triangle> hilbertTriangleList = timeTriangulation(hilbertDelaunay, "Delaunay triangulation in Hilbert order");
+        Delaunay brioDelaunay = Delaunay(pointList, false, InsertionOrder::BRIO);
+        std::vector<Triangle> brioTriangleList = timeTriangulation(brioDelaunay, "Delaunay triangulation in BRIO order");
 
-        std::vector<std::tuple<int, int, int>> trianglesIndexes = getTriangulationIndexes(pointList, triangleList);
-        std::string name = "delaunayTri" + std::to_string(i) + ".txt";
-        createTriangulationFile(name, trianglesIndexes);
+        std::cout << "Number of triangles = " << triangleList.size() << '\n';
+        if(cachedTriangleList != triangleList) {
+            std::cout << "ERROR: cached circumcircles changed the triangulation\n";
+        }
+        std::vector<Triangle> canonicalTriangleList = getCanonicalTriangulation(triangleList);
+        if(getCanonicalTriangulation(hilbertTriangleList) != canonicalTriangleList ||
+           getCanonicalTriangulation(brioTriangleList) != canonicalTriangleList) {
+            std::cout << "ERROR: the insertion order changed the triangulation\n";
+        }
 
+        if(i <= MAX_POINTS_TO_FILE) {
+            createPointCloudFile(i, pointList);
+
+            std::string name = "delaunayTri" + std::to_string(i) + ".txt";
+            createTriangulationFile(name, triangleList);
+        }
+
+        std::cout << "\n\n";
+    }
+
+    std::cout << "Testing with grid point clouds" << '\n';
+    std::vector<int> gridSide{3, 5, 10, 30, 100, 300};
+    for(int side : gridSide) {
+        std::cout << "n = " << side * side << '\n';
+        std::vector<Point> pointList = generateGridPointList(side);
+
+        Delaunay delaunay = Delaunay(pointList);
+        std::vector<Triangle> triangleList = timeTriangulation(delaunay, "Delaunay triangulation");
+        Delaunay cachedDelaunay = Delaunay(pointList, true);
+        std::vector<Triangle> cachedTriangleList = timeTriangulation(cachedDelaunay, "Delaunay triangulation with cached circumcircles");
+
+        // two triangles per grid cell
+        std::cout << "Number of triangles = " << triangleList.size() << " (expected " << 2 * (side - 1) * (side - 1) << ")" << '\n';
+        if(triangleList.size() != (size_t) 2 * (side - 1) * (side - 1)) {
+            std::cout << "ERROR: wrong number of triangles\n";
+        }
+        if(cachedTriangleList != triangleList) {
+            std::cout << "ERROR: cached circumcircles changed the triangulation\n";
+        }
+
+        // every cell has four cocircular corners, so the diagonals are only
+        // the same through the tie-break of inCircumcircle
+        std::vector<Triangle> canonicalTriangleList = getCanonicalTriangulation(triangleList);
+        Delaunay hilbertDelaunay = Delaunay(pointList, false, InsertionOrder::Hilbert);
+        Delaunay brioDelaunay = Delaunay(pointList, false, InsertionOrder::BRIO);
+        if(getCanonicalTriangulation(hilbertDelaunay.triangulate()) != canonicalTriangleList ||
+           getCanonicalTriangulation(brioDelaunay.triangulate()) != canonicalTriangleList) {
+            std::cout << "ERROR: the insertion order changed the triangulation\n";
+        }
+        for(int numThreads : {1, 2, 4}) {
+            ParallelDelaunay parallelDelaunay = ParallelDelaunay(pointList, numThreads);
+            if(getCanonicalTriangulation(parallelDelaunay.triangulate()) != canonicalTriangleList) {
+                std::cout << "ERROR: the parallel triangulation with " << numThreads << " threads differs\n";
+            }
+        }
+        std::cout << "\n\n";
+    }
+
+    std::cout << "Testing with repeated points" << '\n';
+    std::vector<double> repeatedPointCloudSize{30, 1e3, 1e5};
+    for(int i : repeatedPointCloudSize) {
+        // every third point appears once more, and the copies are shuffled in
+        // with the rest, so some come before their first occurrence
+        std::vector<Point> pointList = generateRandomPointList(i, STD_DEV);
+        for(int j = 0; j < i; j += 3) {
+            pointList.push_back(pointList[j]);
+        }
+        std::shuffle(pointList.begin(), pointList.end(), std::default_random_engine());
+        std::cout << "n = " << pointList.size() << " (" << i << " distinct)" << '\n';
+
+        Delaunay delaunay = Delaunay(pointList);
+        std::vector<Triangle> triangleList = timeTriangulation(delaunay, "Delaunay triangulation");
+        std::vector<Triangle> canonicalTriangleList = getCanonicalTriangulation(triangleList);
+        Delaunay hilbertDelaunay = Delaunay(pointList, false, InsertionOrder::Hilbert);
+        Delaunay brioDelaunay = Delaunay(pointList, false, InsertionOrder::BRIO);
+        if(getCanonicalTriangulation(hilbertDelaunay.triangulate()) != canonicalTriangleList ||
+           getCanonicalTriangulation(brioDelaunay.triangulate()) != canonicalTriangleList) {
+            std::cout << "ERROR: the insertion order changed the triangulation\n";
+        }
+        ParallelDelaunay parallelDelaunay = ParallelDelaunay(pointList);
+        if(getCanonicalTriangulation(parallelDelaunay.triangulate()) != canonicalTriangleList) {
+            std::cout << "ERROR: the parallel triangulation differs\n";
+        }
+        std::cout << "Number of triangles = " << triangleList.size() << '\n';
+        std::cout << "\n\n";
+    }
+
+    std::cout << "Testing the parallel Delaunay triangulation" << '\n';
+    int maxThreads = std::max<int>(std::thread::hardware_concurrency(), 1);
+    std::vector<double> parallelPointCloudSize{1e3, 1e4, 1e5, 1e6, 5*1e6};
+    for(int i : parallelPointCloudSize) {
+        std::cout << "n = " << i << '\n';
+        std::vector<Point> pointList = generateRandomPointList(i, STD_DEV);
+
+        Delaunay delaunay = Delaunay(pointList, false, InsertionOrder::Hilbert);
+        std::vector<Triangle> triangleList = timeTriangulation(delaunay, "Delaunay triangulation in Hilbert order");
+        std::vector<Triangle> canonicalTriangleList = getCanonicalTriangulation(triangleList);
+        for(int numThreads = 1; ; numThreads = std::min(2 * numThreads, maxThreads)) {
+            ParallelDelaunay parallelDelaunay = ParallelDelaunay(pointList, numThreads);
+            std::vector<Triangle> parallelTriangleList = timeTriangulation(parallelDelaunay,
+                "Parallel Delaunay triangulation with " + std::to_string(numThreads) + " threads");
+            if(getCanonicalTriangulation(parallelTriangleList) != canonicalTriangleList) {
+                std::cout << "ERROR: the parallel triangulation differs\n";
+            }
+            if(numThreads == maxThreads) break;
+        }
+        std::cout << "Number of triangles = " << triangleList.size() << '\n';
         std::cout << "\n\n";
     }
 